@@ -4,8 +4,30 @@
 #include <string>
 #include <optional>
 #include <algorithm>
-#include <regex>
+#include <string_view>
 #include <queue>
+#include <limits>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <barrier>
+#include <atomic>
+#include <bit>
+#include <span>
+#include <functional>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <array>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #ifdef DEBUG
 #include <cassert>
@@ -15,7 +37,13 @@
 constexpr uint32_t LEFT_NUMERIC_LIMIT = 1;
 constexpr uint32_t RIGHT_NUMERIC_LIMIT = 999999999;
 
-enum gate_type {
+// Number of 64-bit words of lanes evaluated per gate in one pass of the
+// bit-parallel engine (4 words fill an AVX2 register, 8 an AVX-512 one)
+#ifndef NYSA_LANE_WORDS
+#define NYSA_LANE_WORDS 4
+#endif
+
+enum gate_type : uint8_t {
     START,
     NOT,
     XOR,
@@ -23,6 +51,9 @@ enum gate_type {
     NAND,
     OR,
     NOR,
+    // Constant signals, produced only by the optimisation of a netlist
+    ZERO,
+    ONE,
     INVALID_TYPE
 };
 
@@ -37,11 +68,20 @@ enum gate_type {
 enum err_type {
     SYNTAX_ERROR,
     REPEATED_NODE,
-    CYCLE
+    CYCLE,
+    INVALID_OPTION,
+    INPUT_ERROR,
+    OSCILLATION,
+    BDD_LIMIT
 };
 
+/**
+ * Prints the message of @p error. @p line_number and @p line are the line
+ * of the input (or the option or the file), @p node_id the signal and
+ * @p count the number of rows or nodes the message refers to.
+ */
 inline void display_error(err_type error, uint64_t line_number = 0,
-                          const std::string &line = "", uint32_t node_id = 0)
+                          std::string_view line = "", uint32_t node_id = 0, uint64_t count = 0)
 {
     switch (error) {
         case SYNTAX_ERROR:
@@ -54,6 +94,20 @@ inline void display_error(err_type error, uint64_t line_number = 0,
         case CYCLE:
             std::cerr << "Error: sequential logic analysis has not yet been implemented.\n";
             break;
+        case INVALID_OPTION:
+            std::cerr << "Error: invalid option " << line << "\n";
+            break;
+        case INPUT_ERROR:
+            std::cerr << "Error: cannot read file " << line << "\n";
+            break;
+        case OSCILLATION:
+            std::cerr << "Warning: signals " << line << " have not settled in "
+                      << count << " rows.\n";
+            break;
+        case BDD_LIMIT:
+            std::cerr << "Error: the binary decision diagrams need more than "
+                      << count << " nodes.\n";
+            break;
         default:
 #ifdef DEBUG
             assert(false);
@@ -63,6 +117,56 @@ inline void display_error(err_type error, uint64_t line_number = 0,
 }
 
 
+/********************************
+ *
+ *          STATISTICS
+ *
+ ********************************/
+
+
+// Phases of a run and events counted with the "stats" option
+enum statistic {
+    PARSE_NS,
+    START_NODES_NS,
+    TOPO_SORT_NS,
+    COMPILE_NS,
+    OPTIMISE_NS,
+    SIMULATE_NS,
+    PRINT_NS,
+    HASH_LOOKUPS,
+    BYTES_WRITTEN,
+    STATISTICS_COUNT
+};
+
+// Names of the statistics in the printed JSON object
+constexpr const char *STATISTIC_NAMES[STATISTICS_COUNT] = {
+    "parse_ns",
+    "start_nodes_ns",
+    "topo_sort_ns",
+    "compile_ns",
+    "optimise_ns",
+    "simulate_ns",
+    "print_ns",
+    "hash_lookups",
+    "bytes_written"
+};
+
+// Values of the statistics. Every function adds its local counts once,
+// so the counting costs nothing in the loops, whether they are printed or not.
+std::array<std::atomic<uint64_t>, STATISTICS_COUNT> statistics;
+
+inline void add_statistic(statistic kind, uint64_t value) {
+    statistics[kind].fetch_add(value, std::memory_order_relaxed);
+}
+
+/**
+ * Returns the number of nanoseconds since @p start.
+ */
+inline uint64_t elapsed_ns(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+
 /********************************
  *
  *          DATA TYPES
@@ -70,12 +174,21 @@ inline void display_error(err_type error, uint64_t line_number = 0,
 ********************************/
 
 
-// Gate type + signal's value + incoming edges
-using Node = std::tuple<gate_type, bool, std::vector<uint32_t>>;
+// Gate type + position of the incoming edges in the graph's edge arena
+// + their number
+using Node = std::tuple<gate_type, uint32_t, uint32_t>;
 // Node + its index
 using Node_Spec = std::pair<Node, uint32_t>;
-// Node's index (i.e. key) + Node's data
-using Graph = std::unordered_map<uint32_t, Node>;
+// Indices of the nodes in the order of their insertion + the nodes' data
+// + incoming edges of all nodes one after another (indices of the nodes
+// while the graph is built, positions in the first two arrays once it is
+// complete) + open-addressing table of the positions of the nodes by
+// their indices (position + 1, 0 for empty slots, at most half full)
+using Graph = std::tuple<std::vector<uint32_t>, std::vector<Node>, std::vector<uint32_t>,
+                         std::vector<uint32_t>>;
+
+// Position returned for a node which is not in the graph
+constexpr uint32_t NO_NODE = std::numeric_limits<uint32_t>::max();
 
 
 /********************************
@@ -88,16 +201,97 @@ inline gate_type get_gate_type(const Node &node) {
     return std::get<0>(node);
 }
 
-inline bool &get_signal(Node &node) {
-    return std::get<1>(node);
+inline const std::vector<uint32_t> &get_node_IDs(const Graph &graph) {
+    return std::get<0>(graph);
+}
+
+inline const std::vector<Node> &get_nodes(const Graph &graph) {
+    return std::get<1>(graph);
+}
+
+inline uint32_t get_graph_size(const Graph &graph) {
+    return get_node_IDs(graph).size();
+}
+
+inline gate_type get_gate_type(const Graph &graph, uint32_t position) {
+    return get_gate_type(get_nodes(graph)[position]);
+}
+
+inline std::span<const uint32_t> get_incoming_edges(const Graph &graph, uint32_t position) {
+    const auto &[type, first_edge, edges] = get_nodes(graph)[position];
+    return { std::get<2>(graph).data() + first_edge, edges };
+}
+
+/**
+ * Returns the slot of the table in which the search for the node with
+ * index @p ID starts.
+ */
+inline std::size_t graph_slot(const std::vector<uint32_t> &table, uint32_t ID) {
+    return (uint64_t{ID} * 0x9E3779B97F4A7C15) >> (std::numeric_limits<uint64_t>::digits
+                                                    - std::countr_zero(table.size()));
+}
+
+/**
+ * Returns the position of the node with index @p ID in the graph,
+ * or @p NO_NODE if there is no such node.
+ */
+inline uint32_t find_node(const Graph &graph, uint32_t ID) {
+    const std::vector<uint32_t> &table = std::get<3>(graph);
+    if (table.empty()) {
+        return NO_NODE;
+    }
+    for (std::size_t slot = graph_slot(table, ID); table[slot] != 0; slot = (slot + 1) & (table.size() - 1)) {
+        if (get_node_IDs(graph)[table[slot] - 1] == ID) {
+            return table[slot] - 1;
+        }
+    }
+    return NO_NODE;
 }
 
-inline bool cget_signal(const Node &node) {
-    return std::get<1>(node);
+/**
+ * Makes room in the table for @p nodes nodes in total, so that it does
+ * not grow until then.
+ */
+void reserve_nodes(Graph &graph, std::size_t nodes) {
+    std::vector<uint32_t> &table = std::get<3>(graph);
+    if (2 * nodes <= table.size()) {
+        return;
+    }
+
+    table.assign(std::bit_ceil(std::max<std::size_t>(2 * nodes, 16)), 0);
+    for (uint32_t position = 0; position < get_graph_size(graph); ++position) {
+        std::size_t slot = graph_slot(table, get_node_IDs(graph)[position]);
+        while (table[slot] != 0) {
+            slot = (slot + 1) & (table.size() - 1);
+        }
+        table[slot] = position + 1;
+    }
+    std::get<0>(graph).reserve(nodes);
+    std::get<1>(graph).reserve(nodes);
 }
 
-inline std::vector<uint32_t> &get_incoming_edges(Node &node) {
-    return std::get<2>(node);
+/**
+ * Adds the node with index @p ID to the graph, its incoming edges
+ * have to be in the edge arena already. Returns false if the graph
+ * already contains the node.
+ */
+inline bool insert_node(Graph &graph, uint32_t ID, const Node &node) {
+    if (2 * (get_graph_size(graph) + 1) > std::get<3>(graph).size()) {
+        reserve_nodes(graph, 2 * get_graph_size(graph) + 1);
+    }
+
+    std::vector<uint32_t> &table = std::get<3>(graph);
+    std::size_t slot = graph_slot(table, ID);
+    for (; table[slot] != 0; slot = (slot + 1) & (table.size() - 1)) {
+        if (get_node_IDs(graph)[table[slot] - 1] == ID) {
+            return false;
+        }
+    }
+
+    table[slot] = get_graph_size(graph) + 1;
+    std::get<0>(graph).push_back(ID);
+    std::get<1>(graph).push_back(node);
+    return true;
 }
 
 
@@ -108,7 +302,7 @@ inline std::vector<uint32_t> &get_incoming_edges(Node &node) {
  ********************************/
 
 
-gate_type get_type(const std::string &name) {
+gate_type get_type(std::string_view name) {
     if (name == "NOT") {
         return NOT;
     }
@@ -135,85 +329,166 @@ gate_type get_type(const std::string &name) {
 /**
  * If the string represents a number in range @p [LEFT_NUMERIC_LIMIT, @p RIGHT_NUMERIC_LIMIT],
  * returns it as a @p uint32_t. Otherwise, returns an empty object. The function
- * assumes there are no whitespaces in the string.
+ * assumes there are no whitespaces in the string. Like @p std::stoul, it accepts
+ * a leading plus sign and leading zeros.
  */
-inline std::optional<uint32_t> get_number(const std::string &s) {
-#ifdef DEBUG
-    assert(sizeof(unsigned long) >= sizeof(uint32_t));
-#endif
-    std::size_t characters_processed;
-    try {
-        const unsigned long number = std::stoul(s, &characters_processed);
-        if (number < LEFT_NUMERIC_LIMIT || number > RIGHT_NUMERIC_LIMIT || characters_processed < s.length()) {
+inline std::optional<uint32_t> get_number(std::string_view s) {
+    if (not s.empty() && s.front() == '+') {
+        s.remove_prefix(1);
+    }
+    if (s.empty()) {
+        return {};
+    }
+
+    uint64_t number = 0;
+    for (auto c : s) {
+        if (c < '0' || c > '9') {
             return {};
         }
-        return { static_cast<uint32_t>(number) };
-    } catch (const std::exception &e) {
+        // Saturating, so that long strings of digits cannot overflow
+        number = std::min<uint64_t>(number * 10 + (c - '0'), uint64_t{RIGHT_NUMERIC_LIMIT} + 1);
+    }
+
+    if (number < LEFT_NUMERIC_LIMIT || number > RIGHT_NUMERIC_LIMIT) {
         return {};
     }
+    return { static_cast<uint32_t>(number) };
 }
 
 /**
- * Parses the given string extracting information of a single node
- * and returns it wrapped in an @p std::optional object. If the line
- * has some syntax errors, the function returns an empty object.
+ * Works like @p get_number, but accepts any number of a row of the truth
+ * table, from 0 to the largest @p uint64_t.
  */
-std::optional<Node_Spec> get_node(const std::string &line) {
-    const std::regex reg("(?:^|\\s+)([^\\s]+)");
-    std::sregex_iterator rin(line.begin(), line.end(), reg);
-    std::sregex_iterator rend;
-
-    if (rin == rend) {
+inline std::optional<uint64_t> get_row_number(std::string_view s) {
+    if (not s.empty() && s.front() == '+') {
+        s.remove_prefix(1);
+    }
+    if (s.empty()) {
         return {};
     }
 
-    const gate_type type = get_type(rin->str(1));
-    ++rin;
+    uint64_t number = 0;
+    for (auto c : s) {
+        if (c < '0' || c > '9') {
+            return {};
+        }
+        const uint64_t digit = c - '0';
+        if (number > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+            return {};
+        }
+        number = number * 10 + digit;
+    }
 
-    if (type == INVALID_TYPE || rin == rend) {
-        return {};
+    return { number };
+}
+
+/**
+ * Checks if the character is a whitespace, i.e. one of the characters
+ * matched by @p \\s in the "C" locale.
+ */
+inline bool is_whitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+/**
+ * Cuts the first whitespace-separated token off the front of @p rest
+ * and returns it. Returns an empty view if there are no more tokens.
+ */
+inline std::string_view next_token(std::string_view &rest) {
+    std::size_t begin = 0;
+    while (begin < rest.size() && is_whitespace(rest[begin])) {
+        ++begin;
+    }
+    std::size_t end = begin;
+    while (end < rest.size() && not is_whitespace(rest[end])) {
+        ++end;
     }
 
-    const std::optional<uint32_t> node_id = get_number(rin->str(1));
-    ++rin;
+    const std::string_view token = rest.substr(begin, end - begin);
+    rest.remove_prefix(end);
+    return token;
+}
 
-    if (!node_id.has_value() || rin == rend) {
+/**
+ * Parses the given string extracting information of a single node
+ * and returns it wrapped in an @p std::optional object. If the line
+ * has some syntax errors, the function returns an empty object.
+ * The line is scanned in place; the node's incoming edges are appended
+ * to the edge arena @p edges, which is left unchanged after an error.
+ */
+std::optional<Node_Spec> get_node(std::string_view line, std::vector<uint32_t> &edges) {
+    const gate_type type = get_type(next_token(line));
+    if (type == INVALID_TYPE) {
         return {};
     }
 
-    std::vector<uint32_t> incoming_nodes;
+    const std::optional<uint32_t> node_id = get_number(next_token(line));
+    if (!node_id.has_value()) {
+        return {};
+    }
 
-    while (rin != rend) {
-        const std::optional<uint32_t> out_node = get_number(rin->str(1));
+    const std::size_t first_edge = edges.size();
+    for (std::string_view token = next_token(line); not token.empty(); token = next_token(line)) {
+        const std::optional<uint32_t> out_node = get_number(token);
         if (!out_node.has_value()) {
+            edges.resize(first_edge);
             return {};
         }
-        incoming_nodes.push_back(out_node.value());
-        ++rin;
+        edges.push_back(out_node.value());
     }
 
-    if ((type == NOT && incoming_nodes.size() != 1)
-        || (type == XOR && incoming_nodes.size() != 2)
-        || (type != NOT && type != XOR && incoming_nodes.size() < 2)) {
+    const std::size_t incoming_nodes = edges.size() - first_edge;
+    if ((type == NOT && incoming_nodes != 1)
+        || (type == XOR && incoming_nodes != 2)
+        || (type != NOT && type != XOR && incoming_nodes < 2)) {
+        edges.resize(first_edge);
         return {};
     }
     else {
-        return { { { type, false, incoming_nodes }, node_id.value() } };
+        return { { { type, first_edge, incoming_nodes }, node_id.value() } };
     }
 }
 
 /**
- * The function adds the missing start nodes to the graph.
+ * The function adds the missing start nodes to the graph and replaces
+ * the indices in the edge arena with the positions of the nodes.
  */
 inline void add_start_nodes(Graph &graph) {
-    for (auto &node : graph) {
-        std::vector<uint32_t> &incoming_edges = get_incoming_edges(node.second);
-        for (auto edge : incoming_edges) {
-            if (graph.find(edge) == graph.end()) {
-                graph[edge] = { START, false, {} };
-            }
+    const auto start = std::chrono::steady_clock::now();
+    const uint32_t nodes = get_graph_size(graph);
+
+    // Adding start nodes adds no edges, so the arena stays in place
+    for (auto &edge : std::get<2>(graph)) {
+        uint32_t position = find_node(graph, edge);
+        if (position == NO_NODE) {
+            position = get_graph_size(graph);
+            insert_node(graph, edge, { START, 0, 0 });
         }
+        edge = position;
+    }
+
+    add_statistic(HASH_LOOKUPS, std::get<2>(graph).size() + get_graph_size(graph) - nodes);
+    add_statistic(START_NODES_NS, elapsed_ns(start));
+}
+
+/**
+ * Adds the node parsed from the line number @p line_number to the graph,
+ * its incoming edges have to be in the graph's edge arena already.
+ * Returns false after reporting an error if the line has a syntax error
+ * or the node is already in the graph.
+ */
+inline bool add_node(Graph &graph, std::optional<Node_Spec> &node,
+                     std::string_view line, uint64_t line_number)
+{
+    if (not node.has_value()) {
+        display_error(SYNTAX_ERROR, line_number, line);
+        return false;
+    }
+    if (not insert_node(graph, node.value().second, node.value().first)) {
+        display_error(REPEATED_NODE, line_number, "", node.value().second);
+        return false;
     }
+    return true;
 }
 
 /**
@@ -229,34 +504,188 @@ std::optional<Graph> get_graph() {
     bool found_error = false;
 
     while (std::getline(std::cin, line)) {
-        std::optional<Node_Spec> node = get_node(line);
-
-        if (not node.has_value()) {
-            display_error(SYNTAX_ERROR, line_number, line);
+        std::optional<Node_Spec> node = get_node(line, std::get<2>(graph));
+        if (not add_node(graph, node, line, line_number)) {
             found_error = true;
         }
-        else {
-            if (graph.find(node.value().second) != graph.end()) {
-                display_error(REPEATED_NODE, line_number, "", node.value().second);
-                found_error = true;
+
+        ++line_number;
+    }
+    add_statistic(HASH_LOOKUPS, line_number - 1);
+
+    if (not found_error) {
+        add_start_nodes(graph);
+        return { std::move(graph) };
+    }
+    else {
+        return {};
+    }
+}
+
+
+/********************************
+ *
+ *   PARALLEL PARSING OF A FILE
+ *
+ ********************************/
+
+
+// Node parsed from a line (empty if the line has syntax errors) + the line
+using Parsed_Line = std::pair<std::optional<Node_Spec>, std::string_view>;
+// Nodes parsed from the lines of a chunk + edge arena of the chunk
+using Parsed_Chunk = std::pair<std::vector<Parsed_Line>, std::vector<uint32_t>>;
+
+// Number of chunks of the file per parsing thread
+constexpr std::size_t CHUNKS_PER_THREAD = 4;
+
+/**
+ * Splits the text into about @p chunks pieces, each ending right after
+ * a newline character (except for the last one).
+ */
+std::vector<std::string_view> split_into_chunks(std::string_view text, std::size_t chunks) {
+    std::vector<std::string_view> result;
+    std::size_t begin = 0;
+
+    for (std::size_t i = 1; i <= chunks && begin < text.size(); ++i) {
+        std::size_t end = text.size();
+        if (i < chunks) {
+            end = text.find('\n', std::max(begin, text.size() / chunks * i));
+            end = end == std::string_view::npos ? text.size() : end + 1;
+        }
+        result.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+
+    return result;
+}
+
+/**
+ * Parses consecutive lines of the chunk into a separate edge arena.
+ * Like @p std::getline, treats the text after the last newline as a line
+ * only if it is not empty.
+ */
+Parsed_Chunk parse_chunk(std::string_view chunk) {
+    Parsed_Chunk parsed;
+
+    while (not chunk.empty()) {
+        const std::size_t end = std::min(chunk.find('\n'), chunk.size());
+        const std::string_view line = chunk.substr(0, end);
+        parsed.first.emplace_back(get_node(line, parsed.second), line);
+        chunk.remove_prefix(std::min(end + 1, chunk.size()));
+    }
+
+    return parsed;
+}
+
+/**
+ * Maps the file at @p path into memory for reading. Returns an empty
+ * object if the file cannot be read.
+ */
+std::optional<std::string_view> map_file(const std::string &path) {
+    const int file = open(path.c_str(), O_RDONLY);
+    struct stat file_stat;
+    if (file < 0 || fstat(file, &file_stat) != 0) {
+        if (file >= 0) {
+            close(file);
+        }
+        return {};
+    }
+
+    const std::size_t size = file_stat.st_size;
+    void *mapping = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0) : nullptr;
+    close(file);
+    if (mapping == MAP_FAILED) {
+        return {};
+    }
+    if (mapping != nullptr) {
+        madvise(mapping, size, MADV_SEQUENTIAL);
+    }
+
+    return { std::string_view(static_cast<const char *>(mapping), size) };
+}
+
+inline void unmap_file(std::string_view text) {
+    if (not text.empty()) {
+        munmap(const_cast<char *>(text.data()), text.size());
+    }
+}
+
+/**
+ * Works like @p get_graph, but reads the input from the @p text of a file
+ * mapped into memory. The text is split into chunks at line boundaries,
+ * the chunks are parsed by @p threads threads and merged into the graph
+ * in the order of lines, so errors are reported exactly like in @p get_graph.
+ */
+std::optional<Graph> get_graph(std::string_view text, uint32_t threads) {
+    const std::vector<std::string_view> chunks = split_into_chunks(text, threads * CHUNKS_PER_THREAD);
+    std::vector<Parsed_Chunk> parsed(chunks.size());
+    {
+        std::atomic<std::size_t> next_chunk = 0;
+        std::vector<std::jthread> workers;
+        for (uint32_t i = 0; i < threads; ++i) {
+            workers.emplace_back([&]() {
+                for (std::size_t chunk = next_chunk++; chunk < chunks.size(); chunk = next_chunk++) {
+                    parsed[chunk] = parse_chunk(chunks[chunk]);
+                }
+            });
+        }
+    }
+
+    std::size_t lines = 0;
+    std::size_t edges = 0;
+    for (const auto &[chunk_lines, chunk_edges] : parsed) {
+        lines += chunk_lines.size();
+        edges += chunk_edges.size();
+    }
+
+    // The graph is built with a few large allocations
+    Graph graph;
+    reserve_nodes(graph, lines);
+    std::get<2>(graph).reserve(edges);
+    uint64_t line_number = 1;
+    bool found_error = false;
+
+    for (auto &chunk : parsed) {
+        auto &[chunk_lines, chunk_edges] = chunk;
+        const uint32_t first_edge = std::get<2>(graph).size();
+        std::get<2>(graph).insert(std::get<2>(graph).end(), chunk_edges.begin(), chunk_edges.end());
+        for (auto &[node, line] : chunk_lines) {
+            if (node.has_value()) {
+                std::get<1>(node.value().first) += first_edge;
             }
-            else {
-                graph[node.value().second] = node.value().first;
+            if (not add_node(graph, node, line, line_number)) {
+                found_error = true;
             }
+            ++line_number;
         }
-
-        ++line_number;
+        Parsed_Chunk().swap(chunk);
     }
+    add_statistic(HASH_LOOKUPS, line_number - 1);
 
     if (not found_error) {
         add_start_nodes(graph);
-        return { graph };
+        return { std::move(graph) };
     }
     else {
         return {};
     }
 }
 
+/**
+ * Works like @p get_graph, but reads the input from the file at @p path.
+ */
+std::optional<Graph> get_graph(const std::string &path, uint32_t threads) {
+    const std::optional<std::string_view> text = map_file(path);
+    if (not text.has_value()) {
+        display_error(INPUT_ERROR, 0, path);
+        return {};
+    }
+
+    std::optional<Graph> graph = get_graph(text.value(), threads);
+    unmap_file(text.value());
+    return graph;
+}
+
 
 /********************************
  *
@@ -268,54 +697,56 @@ std::optional<Graph> get_graph() {
 /**
  * The function finds an order of vertices in which the signals
  * go through the graph. The resulting @p std::vector contains
- * all starting nodes in the increasing order. If a cycle exists
- * in the graph, the function terminates returning
- * an empty @p std::optional object.
+ * the positions of the nodes, all starting nodes first in the
+ * increasing order of their indices. If a cycle exists in the graph,
+ * the function terminates returning an empty @p std::optional object.
  */
-std::optional<std::vector<uint32_t>> topo_sort(Graph &graph) {
+std::optional<std::vector<uint32_t>> topo_sort(const Graph &graph) {
     std::vector<uint32_t> simulation_order;
-    std::unordered_map<uint32_t, uint32_t> parents;
+    std::vector<uint32_t> parents(get_graph_size(graph), 0);
     std::queue<uint32_t> queue;
 
     // Adding the start nodes to the queue
-    for (auto &node : graph) {
-        if (get_incoming_edges(node.second).empty()) {
-            simulation_order.push_back(node.first);
+    for (uint32_t node = 0; node < get_graph_size(graph); ++node) {
+        if (get_incoming_edges(graph, node).empty()) {
+            simulation_order.push_back(node);
         }
-        for (auto neighbour : get_incoming_edges(node.second)) {
+        for (auto neighbour : get_incoming_edges(graph, node)) {
             ++parents[neighbour];
         }
     }
 
     const uint32_t start_nodes = simulation_order.size();
     // Ordering the start nodes
-    std::sort(simulation_order.begin(), simulation_order.end());
+    std::sort(simulation_order.begin(), simulation_order.end(), [&graph](uint32_t a, uint32_t b) {
+        return get_node_IDs(graph)[a] < get_node_IDs(graph)[b];
+    });
 
-    for (auto &node : graph) {
-        if (parents[node.first] == 0 && get_gate_type(node.second) != START) {
-            queue.push(node.first);
+    for (uint32_t node = 0; node < get_graph_size(graph); ++node) {
+        if (parents[node] == 0 && get_gate_type(graph, node) != START) {
+            queue.push(node);
         }
     }
 
     while (not queue.empty()) {
-        uint32_t node_ID = queue.front();
+        uint32_t node = queue.front();
         queue.pop();
-        simulation_order.push_back(node_ID);
+        simulation_order.push_back(node);
 
-        for (auto neighbour : get_incoming_edges(graph[node_ID])) {
+        for (auto neighbour : get_incoming_edges(graph, node)) {
             uint32_t &parent = parents[neighbour];
 #ifdef DEBUG
             assert(parent > 0);
 #endif
             --parent;
-            if (parent == 0 && get_gate_type(graph[neighbour]) != START) {
+            if (parent == 0 && get_gate_type(graph, neighbour) != START) {
                 queue.push(neighbour);
             }
         }
     }
 
     // Cycle
-    if (simulation_order.size() < graph.size()) {
+    if (simulation_order.size() < get_graph_size(graph)) {
         return { };
     }
 
@@ -325,184 +756,3266 @@ std::optional<std::vector<uint32_t>> topo_sort(Graph &graph) {
     return { simulation_order };
 }
 
+/**
+ * Splits the graph into strongly connected components. Returns the order
+ * of the nodes' positions with all starting nodes in the increasing order
+ * of their indices first, followed by the components, each after all the
+ * components its signals depend on, together with the offsets of the
+ * components in that order (one more than the number of components,
+ * the start nodes are not included).
+ */
+std::pair<std::vector<uint32_t>, std::vector<uint32_t>> component_sort(const Graph &graph) {
+    std::vector<uint32_t> simulation_order;
+    std::vector<uint32_t> component_offsets;
+
+    for (uint32_t node = 0; node < get_graph_size(graph); ++node) {
+        if (get_gate_type(graph, node) == START) {
+            simulation_order.push_back(node);
+        }
+    }
+    std::sort(simulation_order.begin(), simulation_order.end(), [&graph](uint32_t a, uint32_t b) {
+        return get_node_IDs(graph)[a] < get_node_IDs(graph)[b];
+    });
+    component_offsets.push_back(simulation_order.size());
+
+    // Tarjan's algorithm, following the edges from gates to their inputs,
+    // so that every component is completed after the ones it depends on
+    constexpr uint32_t UNVISITED = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> visit_index(get_graph_size(graph), UNVISITED);
+    std::vector<uint32_t> low_link(get_graph_size(graph));
+    std::vector<uint8_t> on_stack(get_graph_size(graph), 0);
+    std::vector<uint32_t> stack;
+    // Visited node + number of its inputs already processed
+    std::vector<std::pair<uint32_t, std::size_t>> path;
+    uint32_t visited = 0;
+
+    for (uint32_t start = 0; start < get_graph_size(graph); ++start) {
+        if (get_gate_type(graph, start) == START || visit_index[start] != UNVISITED) {
+            continue;
+        }
+        path.emplace_back(start, 0);
+        visit_index[start] = low_link[start] = visited++;
+        stack.push_back(start);
+        on_stack[start] = 1;
+
+        while (not path.empty()) {
+            auto &[node, processed] = path.back();
+            const std::span<const uint32_t> incoming_edges = get_incoming_edges(graph, node);
+
+            if (processed < incoming_edges.size()) {
+                const uint32_t neighbour = incoming_edges[processed++];
+                if (get_gate_type(graph, neighbour) == START) {
+                    continue;
+                }
+                if (visit_index[neighbour] == UNVISITED) {
+                    visit_index[neighbour] = low_link[neighbour] = visited++;
+                    stack.push_back(neighbour);
+                    on_stack[neighbour] = 1;
+                    path.emplace_back(neighbour, 0);
+                }
+                else if (on_stack[neighbour]) {
+                    low_link[node] = std::min(low_link[node], visit_index[neighbour]);
+                }
+                continue;
+            }
+
+            const uint32_t finished = node;
+            path.pop_back();
+            if (not path.empty()) {
+                low_link[path.back().first] = std::min(low_link[path.back().first], low_link[finished]);
+            }
+
+            if (low_link[finished] == visit_index[finished]) {
+                uint32_t member;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    on_stack[member] = 0;
+                    simulation_order.push_back(member);
+                } while (member != finished);
+                component_offsets.push_back(simulation_order.size());
+            }
+        }
+    }
+
+    return { std::move(simulation_order), std::move(component_offsets) };
+}
+
 
 /********************************
  *
- *          SIMULATION
+ *     NETLIST COMPILATION
  *
  ********************************/
 
 
-inline bool compute_not(Graph &graph, const Graph::iterator &node) {
-    return not get_signal(graph.find(get_incoming_edges(node->second)[0])->second);
-}
+// After the compilation every node is identified by its dense index, i.e.
+// its position in the simulation order, so the start nodes come first.
+// Gate types + offsets of the nodes' fan-ins in the fan-in array (one more
+// than the number of nodes) + fan-ins of consecutive nodes + original
+// indices of the displayed nodes in the increasing order + dense indices
+// of the nodes in the displaying order + number of start nodes
+using Netlist = std::tuple<std::vector<gate_type>, std::vector<uint32_t>, std::vector<uint32_t>,
+                           std::vector<uint32_t>, std::vector<uint32_t>, uint32_t>;
 
-inline bool compute_xor(Graph &graph, const Graph::iterator &node) {
-    const std::vector<uint32_t> &incoming_edges = get_incoming_edges(node->second);
-    bool sig_1 = get_signal(graph.find(incoming_edges[0])->second);
-    bool sig_2 = get_signal(graph.find(incoming_edges[1])->second);
-    return sig_1 ^ sig_2;
-}
 
-inline bool compute_and(Graph &graph, const Graph::iterator &node) {
-    const std::vector<uint32_t> &incoming_edges = get_incoming_edges(node->second);
-    for (const auto &parent : incoming_edges) {
-        if (not get_signal(graph.find(parent)->second)) {
-            return false;
-        }
-    }
+/********************************
+ *
+ *  ACCESS TO A NETLIST'S DATA
+ *
+ ********************************/
 
-    return true;
-}
 
-inline bool compute_nand(Graph &graph, const Graph::iterator &node) {
-    return not compute_and(graph, node);
+inline const std::vector<gate_type> &get_gate_types(const Netlist &netlist) {
+    return std::get<0>(netlist);
 }
 
-inline bool compute_or(Graph &graph, const Graph::iterator &node) {
-    const std::vector<uint32_t> &incoming_edges = get_incoming_edges(node->second);
-    for (const auto &parent : incoming_edges) {
-        if (get_signal(graph.find(parent)->second)) {
-            return true;
-        }
-    }
-
-    return false;
+inline const std::vector<uint32_t> &get_fan_in_offsets(const Netlist &netlist) {
+    return std::get<1>(netlist);
 }
 
-inline bool compute_nor(Graph &graph, const Graph::iterator &node) {
-    return not compute_or(graph, node);
+inline const std::vector<uint32_t> &get_fan_ins(const Netlist &netlist) {
+    return std::get<2>(netlist);
 }
 
-inline bool compute_signal_val(Graph &graph, const Graph::iterator &node) {
-#ifdef DEBUG
-    assert(node != graph.end());
-#endif
-    switch (get_gate_type(node->second)) {
-        case NOT:
-            return compute_not(graph, node);
-        case XOR:
-            return compute_xor(graph, node);
-        case AND:
-            return compute_and(graph, node);
-        case NAND:
-            return compute_nand(graph, node);
-        case OR:
-            return compute_or(graph, node);
-        case NOR:
-            return compute_nor(graph, node);
-        case START:
-            return get_signal(node->second);
-        default:
-#ifdef DEBUG
-            assert(false);
-#endif
-            return false;
-    }
+inline const std::vector<uint32_t> &get_displayed_IDs(const Netlist &netlist) {
+    return std::get<3>(netlist);
 }
 
-inline void print_signals(const Graph &graph, const std::vector<uint32_t> &order) {
-    for (auto node_ID : order) {
-        if (cget_signal(graph.find(node_ID)->second)) {
-            std::cout << '1';
-        }
-        else {
-            std::cout << '0';
-        }
-    }
+inline const std::vector<uint32_t> &get_displaying_order(const Netlist &netlist) {
+    return std::get<4>(netlist);
+}
 
-    std::cout << '\n';
+inline uint32_t get_start_nodes_count(const Netlist &netlist) {
+    return std::get<5>(netlist);
 }
 
-inline bool update_signals(Graph &graph, const std::vector<uint32_t> &node_order,
-                           const uint32_t number_of_start_nodes)
-{
-    for (int32_t i = static_cast<int32_t>(number_of_start_nodes) - 1; i >= 0; --i) {
-        auto node = graph.find(node_order[i]);
-        get_signal(node->second) = not get_signal(node->second);
-        if (get_signal(node->second)) {
-            return true;
-        }
-    }
+inline uint32_t get_nodes_count(const Netlist &netlist) {
+    return get_gate_types(netlist).size();
+}
 
-    return false;
+inline bool is_displayed(const Netlist &netlist, uint32_t ID) {
+    return std::binary_search(get_displayed_IDs(netlist).begin(), get_displayed_IDs(netlist).end(), ID);
 }
 
+
 /**
- * Returns the number of start nodes in the given graph.
+ * Renumbers the nodes of the graph to the indices of their positions
+ * in @p node_order and lays the graph out in contiguous arrays. The graph
+ * is not needed for the simulation afterwards.
  */
-inline uint32_t start_nodes_count(const Graph &graph, const std::vector<uint32_t> &node_order) {
-    uint32_t i = 0;
-    uint32_t j = node_order.size() - 1;
-    uint32_t middle;
+Netlist compile_netlist(const Graph &graph, const std::vector<uint32_t> &node_order) {
+    std::vector<uint32_t> dense_index(get_graph_size(graph));
+    for (uint32_t i = 0; i < node_order.size(); ++i) {
+        dense_index[node_order[i]] = i;
+    }
 
-    while (i < j) {
-        middle = (j - i) / 2 + i;
-        if (get_gate_type(graph.find(node_order[middle])->second) != START) {
-            j = middle;
+    std::vector<gate_type> types;
+    std::vector<uint32_t> fan_in_offsets;
+    std::vector<uint32_t> fan_ins;
+    types.reserve(node_order.size());
+    fan_in_offsets.reserve(node_order.size() + 1);
+
+    uint32_t number_of_start_nodes = 0;
+    for (auto node : node_order) {
+        types.push_back(get_gate_type(graph, node));
+        fan_in_offsets.push_back(fan_ins.size());
+        for (auto parent : get_incoming_edges(graph, node)) {
+            fan_ins.push_back(dense_index[parent]);
         }
-        else {
-            i = middle + 1;
+        if (get_gate_type(graph, node) == START) {
+            ++number_of_start_nodes;
         }
     }
+    fan_in_offsets.push_back(fan_ins.size());
 
-    return i;
-}
+    // The nodes are displayed in the increasing order of their indices
+    std::vector<uint32_t> displayed_IDs(node_order.size());
+    for (uint32_t i = 0; i < node_order.size(); ++i) {
+        displayed_IDs[i] = get_node_IDs(graph)[node_order[i]];
+    }
+    std::vector<uint32_t> displaying_order(node_order.size());
+    for (uint32_t i = 0; i < node_order.size(); ++i) {
+        displaying_order[i] = i;
+    }
+    std::sort(displaying_order.begin(), displaying_order.end(), [&displayed_IDs](uint32_t a, uint32_t b) {
+        return displayed_IDs[a] < displayed_IDs[b];
+    });
+    std::sort(displayed_IDs.begin(), displayed_IDs.end());
 
-/**
- * Performs a simulation going through all permutations of signals
- * that can be assigned to the start nodes and print the resulting
- * state of the system.
- */
-void simulation(Graph &graph, const std::vector<uint32_t> &node_order,
-                const std::vector<uint32_t> &displaying_order)
-{
-    const uint32_t number_of_start_nodes = start_nodes_count(graph, node_order);
-    do {
-        for (uint32_t i = number_of_start_nodes; i < node_order.size(); ++i) {
-            get_signal(graph[node_order[i]]) = compute_signal_val(
-                graph,
-                graph.find(node_order[i])
-            );
-        }
-        print_signals(graph, displaying_order);
-    } while (update_signals(graph, node_order, number_of_start_nodes));
+    return { std::move(types), std::move(fan_in_offsets), std::move(fan_ins),
+             std::move(displayed_IDs), std::move(displaying_order), number_of_start_nodes };
 }
 
 
 /********************************
  *
- *            MAIN
+ *        NETLIST CACHE
  *
  ********************************/
 
 
-int main() {
-    // Parsing the input and building a graph
-    std::optional<Graph> graph = get_graph();
-    if (not graph.has_value()) {
-        return 0;
-    }
+// Beginning of every cache file ("NYSANETL" read as a little-endian number)
+constexpr uint64_t CACHE_MAGIC = 0x4C54454E4153594E;
+// Changed whenever the layout of the cache files or the compilation changes
+constexpr uint64_t CACHE_VERSION = 1;
+// Magic number, version, hash and size of the input, numbers of nodes,
+// start nodes, fan-ins and displayed nodes
+constexpr std::size_t CACHE_HEADER_WORDS = 8;
+
+/**
+ * Returns a 64-bit hash of the text, reading it in 8-byte words.
+ */
+uint64_t text_hash(std::string_view text) {
+    uint64_t hash = 0x9E3779B97F4A7C15 ^ text.size();
+    // The data of an empty text may be a null pointer
+    if (text.empty()) {
+        return hash;
+    }
+    std::size_t i = 0;
+    for (; i + sizeof(uint64_t) <= text.size(); i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, text.data() + i, sizeof(word));
+        hash = std::rotl(hash ^ (word * 0xC2B2AE3D27D4EB4F), 31) * 0x9E3779B97F4A7C15;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, text.data() + i, text.size() - i);
+    hash = std::rotl(hash ^ (tail * 0xC2B2AE3D27D4EB4F), 31) * 0x9E3779B97F4A7C15;
+
+    return hash ^ (hash >> 32);
+}
+
+/**
+ * Returns the path of the file in the directory @p directory caching
+ * the netlist compiled from the input with the hash @p hash.
+ */
+std::string cache_path(const std::string &directory, uint64_t hash) {
+    constexpr char DIGITS[] = "0123456789abcdef";
+    std::string name = "nysa-0000000000000000.bin";
+    for (std::size_t i = 0; i < 16; ++i) {
+        name[5 + i] = DIGITS[(hash >> (60 - 4 * i)) & 0xF];
+    }
+    return directory + "/" + name;
+}
+
+/**
+ * Checks that the arrays of a netlist read from a cache file describe
+ * a topologically sorted netlist, so that a damaged file cannot make
+ * the simulation read out of bounds.
+ */
+bool is_valid_netlist(const Netlist &netlist) {
+    const std::vector<uint32_t> &offsets = get_fan_in_offsets(netlist);
+    if (offsets.front() != 0 || offsets.back() != get_fan_ins(netlist).size()) {
+        return false;
+    }
+    for (uint32_t node = 0; node < get_nodes_count(netlist); ++node) {
+        const gate_type type = get_gate_types(netlist)[node];
+        if (type >= INVALID_TYPE || offsets[node] > offsets[node + 1]
+            || (type == START) != (node < get_start_nodes_count(netlist))) {
+            return false;
+        }
+        // The engines rely on the numbers of inputs accepted by the parser
+        const uint32_t inputs = offsets[node + 1] - offsets[node];
+        const bool constant = type == START || type == ZERO || type == ONE;
+        if ((constant && inputs != 0) || (type == NOT && inputs != 1) || (type == XOR && inputs != 2)
+            || (not constant && type != NOT && type != XOR && inputs < 2)) {
+            return false;
+        }
+        for (uint32_t e = offsets[node]; e < offsets[node + 1]; ++e) {
+            if (get_fan_ins(netlist)[e] >= node) {
+                return false;
+            }
+        }
+    }
+    for (auto node : get_displaying_order(netlist)) {
+        if (node >= get_nodes_count(netlist)) {
+            return false;
+        }
+    }
+    return std::is_sorted(get_displayed_IDs(netlist).begin(), get_displayed_IDs(netlist).end());
+}
+
+/**
+ * Reads the netlist compiled from the input @p text from the cache file
+ * at @p path. Returns an empty object if there is no such file or it was
+ * written for another input or by another version of the program.
+ */
+std::optional<Netlist> load_netlist(const std::string &path, std::string_view text, uint64_t hash) {
+    const std::optional<std::string_view> file = map_file(path);
+    if (not file.has_value()) {
+        return {};
+    }
+
+    std::optional<Netlist> netlist;
+    uint64_t header[CACHE_HEADER_WORDS];
+    if (file.value().size() >= sizeof(header)) {
+        std::memcpy(header, file.value().data(), sizeof(header));
+        const auto [magic, version, input_hash, input_size, nodes, start_nodes, fan_ins, columns] = header;
+        const std::size_t types_bytes = (nodes + 7) / 8 * 8;
+
+        if (magic == CACHE_MAGIC && version == CACHE_VERSION && input_hash == hash && input_size == text.size()
+            && nodes <= RIGHT_NUMERIC_LIMIT && fan_ins <= std::numeric_limits<uint32_t>::max()
+            && columns <= nodes && start_nodes <= nodes
+            && file.value().size() == sizeof(header) + types_bytes
+                                      + sizeof(uint32_t) * (nodes + 1 + fan_ins + 2 * columns)) {
+            const char *data = file.value().data() + sizeof(header);
+            auto read_array = [&data](auto &array, std::size_t size) {
+                array.resize(size);
+                std::memcpy(array.data(), data, size * sizeof(array[0]));
+                data += size * sizeof(array[0]);
+            };
+
+            netlist.emplace();
+            auto &[types, offsets, fan_in_array, displayed_IDs, displaying_order, start_count] = netlist.value();
+            read_array(types, nodes);
+            data += types_bytes - nodes;
+            read_array(offsets, nodes + 1);
+            read_array(fan_in_array, fan_ins);
+            read_array(displayed_IDs, columns);
+            read_array(displaying_order, columns);
+            start_count = start_nodes;
+
+            if (not is_valid_netlist(netlist.value())) {
+                netlist.reset();
+            }
+        }
+    }
+
+    unmap_file(file.value());
+    return netlist;
+}
+
+/**
+ * Writes the netlist compiled from the input @p text to the cache file
+ * at @p path, so that the next run can map it instead of parsing the
+ * input. The file is renamed into place only once it is complete.
+ */
+void save_netlist(const std::string &path, const Netlist &netlist, std::string_view text, uint64_t hash) {
+    const uint64_t header[CACHE_HEADER_WORDS] = {
+        CACHE_MAGIC, CACHE_VERSION, hash, text.size(), get_nodes_count(netlist),
+        get_start_nodes_count(netlist), get_fan_ins(netlist).size(), get_displayed_IDs(netlist).size()
+    };
+    const std::string temporary_path = path + "." + std::to_string(getpid());
+    std::ofstream file(temporary_path, std::ios::binary);
+
+    auto write_array = [&file](const auto &array) {
+        file.write(reinterpret_cast<const char *>(array.data()), array.size() * sizeof(array[0]));
+    };
+    file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    write_array(get_gate_types(netlist));
+    file.write("\0\0\0\0\0\0\0", (8 - get_nodes_count(netlist) % 8) % 8);
+    write_array(get_fan_in_offsets(netlist));
+    write_array(get_fan_ins(netlist));
+    write_array(get_displayed_IDs(netlist));
+    write_array(get_displaying_order(netlist));
+    file.close();
+
+    // The cache only saves time, so failing to write it is not an error
+    if (not file || std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+        std::remove(temporary_path.c_str());
+    }
+}
+
+
+/********************************
+ *
+ *         OPTIMISATION
+ *
+ ********************************/
+
+
+// Gate type + fan-ins of a gate after the optimisation
+using Gate_Key = std::pair<gate_type, std::vector<uint32_t>>;
+
+/**
+ * Returns the gate type negated by @p NAND or @p NOR, i.e. @p AND or @p OR.
+ * Other gate types are returned unchanged.
+ */
+inline gate_type negated_type(gate_type type) {
+    switch (type) {
+        case NAND:
+            return AND;
+        case NOR:
+            return OR;
+        default:
+            return type;
+    }
+}
+
+/**
+ * Simplifies the fan-ins of a gate (already renumbered to the optimised
+ * netlist) and returns the simplified gate. @p AND, @p OR and their negations
+ * drop repeated and neutral inputs and become constants if they have
+ * a dominating input or a pair of complementary ones. A gate left with
+ * a single input becomes @p AND of it (an alias) or @p NOT of it.
+ */
+Gate_Key simplify_gate(gate_type type, std::vector<uint32_t> fan_ins,
+                       const std::vector<gate_type> &types, const std::vector<uint32_t> &fan_in_offsets,
+                       const std::vector<uint32_t> &new_fan_ins)
+{
+    auto is = [&types](uint32_t node, gate_type constant) { return types[node] == constant; };
+    const bool negated = type == NAND || type == NOR;
+    const gate_type base = negated_type(type);
+
+    if (type == NOT) {
+        if (is(fan_ins[0], ZERO) || is(fan_ins[0], ONE)) {
+            return { is(fan_ins[0], ZERO) ? ONE : ZERO, {} };
+        }
+        // A double negation is an alias of the inner gate's input
+        if (is(fan_ins[0], NOT)) {
+            return { AND, { new_fan_ins[fan_in_offsets[fan_ins[0]]] } };
+        }
+        return { NOT, std::move(fan_ins) };
+    }
+
+    if (type == XOR) {
+        if (fan_ins[0] == fan_ins[1]) {
+            return { ZERO, {} };
+        }
+        std::sort(fan_ins.begin(), fan_ins.end());
+        for (uint32_t i = 0; i < 2; ++i) {
+            if (is(fan_ins[i], ZERO)) {
+                return { AND, { fan_ins[1 - i] } };
+            }
+            if (is(fan_ins[i], ONE)) {
+                return simplify_gate(NOT, { fan_ins[1 - i] }, types, fan_in_offsets, new_fan_ins);
+            }
+        }
+        return { XOR, std::move(fan_ins) };
+    }
+
+    const gate_type dominating = base == AND ? ZERO : ONE;
+    const gate_type neutral = base == AND ? ONE : ZERO;
+    const gate_type dominated_result = (dominating == ONE) != negated ? ONE : ZERO;
+
+    std::sort(fan_ins.begin(), fan_ins.end());
+    fan_ins.erase(std::unique(fan_ins.begin(), fan_ins.end()), fan_ins.end());
+    fan_ins.erase(std::remove_if(fan_ins.begin(), fan_ins.end(), [&](uint32_t node) {
+        return is(node, neutral);
+    }), fan_ins.end());
+
+    for (auto node : fan_ins) {
+        const bool complemented = is(node, NOT)
+            && std::binary_search(fan_ins.begin(), fan_ins.end(), new_fan_ins[fan_in_offsets[node]]);
+        if (is(node, dominating) || complemented) {
+            return { dominated_result, {} };
+        }
+    }
+
+    if (fan_ins.empty()) {
+        return { (neutral == ONE) != negated ? ONE : ZERO, {} };
+    }
+    if (fan_ins.size() == 1) {
+        return negated ? simplify_gate(NOT, std::move(fan_ins), types, fan_in_offsets, new_fan_ins)
+                       : Gate_Key{ AND, std::move(fan_ins) };
+    }
+    return { type, std::move(fan_ins) };
+}
+
+/**
+ * Builds a netlist displaying the same signals as the given one, but with
+ * fewer gates to evaluate: constants are folded, double negations collapsed,
+ * and structurally identical gates (the same type over the same inputs) are
+ * evaluated once, with all of their columns displaying the shared node.
+ * Stores in @p saved the number of gate evaluations saved per row.
+ */
+Netlist optimise_netlist(const Netlist &netlist, uint32_t &saved) {
+    const uint32_t number_of_start_nodes = get_start_nodes_count(netlist);
+    std::vector<gate_type> types(get_gate_types(netlist).begin(),
+                                 get_gate_types(netlist).begin() + number_of_start_nodes);
+    std::vector<uint32_t> fan_in_offsets(number_of_start_nodes + 1, 0);
+    std::vector<uint32_t> fan_ins;
+
+    // Node of the optimised netlist with the signal of every original node
+    std::vector<uint32_t> representative(get_nodes_count(netlist));
+    for (uint32_t i = 0; i < number_of_start_nodes; ++i) {
+        representative[i] = i;
+    }
+    // Gates already in the optimised netlist
+    std::map<Gate_Key, uint32_t> existing_gates;
+
+    for (uint32_t i = number_of_start_nodes; i < get_nodes_count(netlist); ++i) {
+        std::vector<uint32_t> gate_fan_ins;
+        for (uint32_t e = get_fan_in_offsets(netlist)[i]; e < get_fan_in_offsets(netlist)[i + 1]; ++e) {
+            gate_fan_ins.push_back(representative[get_fan_ins(netlist)[e]]);
+        }
+
+        Gate_Key gate = simplify_gate(get_gate_types(netlist)[i], std::move(gate_fan_ins),
+                                      types, fan_in_offsets, fan_ins);
+        if (gate.first == AND && gate.second.size() == 1) {
+            representative[i] = gate.second[0];
+            continue;
+        }
+
+        const auto [existing, inserted] = existing_gates.try_emplace(gate, types.size());
+        if (inserted) {
+            types.push_back(gate.first);
+            fan_ins.insert(fan_ins.end(), gate.second.begin(), gate.second.end());
+            fan_in_offsets.push_back(fan_ins.size());
+        }
+        representative[i] = existing->second;
+    }
+
+    std::vector<uint32_t> displaying_order;
+    for (auto node : get_displaying_order(netlist)) {
+        displaying_order.push_back(representative[node]);
+    }
+
+    saved = get_nodes_count(netlist) - types.size();
+    return { std::move(types), std::move(fan_in_offsets), std::move(fan_ins),
+             get_displayed_IDs(netlist), std::move(displaying_order), number_of_start_nodes };
+}
+
+
+/********************************
+ *
+ *          SIMULATION
+ *
+ ********************************/
+
+
+// Signals of the nodes indexed by their dense indices (0 or 1)
+using Signals = std::vector<uint8_t>;
+
+inline bool compute_not(const Netlist &netlist, const Signals &signals, uint32_t node) {
+    return not signals[get_fan_ins(netlist)[get_fan_in_offsets(netlist)[node]]];
+}
+
+inline bool compute_xor(const Netlist &netlist, const Signals &signals, uint32_t node) {
+    const uint32_t offset = get_fan_in_offsets(netlist)[node];
+    bool sig_1 = signals[get_fan_ins(netlist)[offset]];
+    bool sig_2 = signals[get_fan_ins(netlist)[offset + 1]];
+    return sig_1 ^ sig_2;
+}
+
+inline bool compute_and(const Netlist &netlist, const Signals &signals, uint32_t node) {
+    const std::vector<uint32_t> &fan_ins = get_fan_ins(netlist);
+    for (uint32_t e = get_fan_in_offsets(netlist)[node]; e < get_fan_in_offsets(netlist)[node + 1]; ++e) {
+        if (not signals[fan_ins[e]]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+inline bool compute_nand(const Netlist &netlist, const Signals &signals, uint32_t node) {
+    return not compute_and(netlist, signals, node);
+}
+
+inline bool compute_or(const Netlist &netlist, const Signals &signals, uint32_t node) {
+    const std::vector<uint32_t> &fan_ins = get_fan_ins(netlist);
+    for (uint32_t e = get_fan_in_offsets(netlist)[node]; e < get_fan_in_offsets(netlist)[node + 1]; ++e) {
+        if (signals[fan_ins[e]]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline bool compute_nor(const Netlist &netlist, const Signals &signals, uint32_t node) {
+    return not compute_or(netlist, signals, node);
+}
+
+inline bool compute_signal_val(const Netlist &netlist, const Signals &signals, uint32_t node) {
+#ifdef DEBUG
+    assert(node < get_nodes_count(netlist));
+#endif
+    switch (get_gate_types(netlist)[node]) {
+        case NOT:
+            return compute_not(netlist, signals, node);
+        case XOR:
+            return compute_xor(netlist, signals, node);
+        case AND:
+            return compute_and(netlist, signals, node);
+        case NAND:
+            return compute_nand(netlist, signals, node);
+        case OR:
+            return compute_or(netlist, signals, node);
+        case NOR:
+            return compute_nor(netlist, signals, node);
+        case START:
+            return signals[node];
+        case ZERO:
+            return false;
+        case ONE:
+            return true;
+        default:
+#ifdef DEBUG
+            assert(false);
+#endif
+            return false;
+    }
+}
+
+/**
+ * Extends @p output by @p rows rows of the netlist's truth table, filled
+ * with newline characters, and returns a pointer to the first new character.
+ */
+inline char *append_rows(const Netlist &netlist, std::string &output, uint64_t rows) {
+    const std::size_t old_size = output.size();
+    output.resize(old_size + rows * (get_displaying_order(netlist).size() + 1), '\n');
+    return output.data() + old_size;
+}
+
+inline void print_signals(const Netlist &netlist, const Signals &signals, std::string &output) {
+    char *row = append_rows(netlist, output, 1);
+    for (auto node : get_displaying_order(netlist)) {
+        *row++ = signals[node] ? '1' : '0';
+    }
+}
+
+inline bool update_signals(const Netlist &netlist, Signals &signals) {
+    for (int32_t i = static_cast<int32_t>(get_start_nodes_count(netlist)) - 1; i >= 0; --i) {
+        signals[i] = not signals[i];
+        if (signals[i]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Returns the number of the last row of the truth table. With 64 or more
+ * start nodes the enumeration cannot finish anyway, so it stops after
+ * 2^64 rows.
+ */
+inline uint64_t last_row_number(const Netlist &netlist) {
+    if (get_start_nodes_count(netlist) < std::numeric_limits<uint64_t>::digits) {
+        return (uint64_t{1} << get_start_nodes_count(netlist)) - 1;
+    }
+    return std::numeric_limits<uint64_t>::max();
+}
+
+/**
+ * Returns the signal of the start node with dense index @p node
+ * in the row number @p row. The first start node holds the most
+ * significant bit of the row's number.
+ */
+inline bool start_signal(const Netlist &netlist, uint32_t node, uint64_t row) {
+    const uint32_t bit = get_start_nodes_count(netlist) - 1 - node;
+    return bit < std::numeric_limits<uint64_t>::digits && ((row >> bit) & 1) != 0;
+}
+
+/**
+ * Performs a simulation going through the permutations of signals
+ * number @p first_row to @p last_row that can be assigned to the start
+ * nodes and appends the resulting states of the system to @p output.
+ */
+void scalar_simulation(const Netlist &netlist, uint64_t first_row, uint64_t last_row, std::string &output) {
+    Signals signals(get_nodes_count(netlist), 0);
+    for (uint32_t i = 0; i < get_start_nodes_count(netlist); ++i) {
+        signals[i] = start_signal(netlist, i, first_row);
+    }
+
+    for (uint64_t row = first_row; ; ++row) {
+        for (uint32_t i = get_start_nodes_count(netlist); i < get_nodes_count(netlist); ++i) {
+            signals[i] = compute_signal_val(netlist, signals, i);
+        }
+        print_signals(netlist, signals, output);
+
+        if (row == last_row) {
+            break;
+        }
+        update_signals(netlist, signals);
+    }
+}
+
+
+/********************************
+ *
+ *    BIT-PARALLEL SIMULATION
+ *
+ ********************************/
+
+
+// Signals of a node in 64 consecutive input combinations, one per bit
+using Lanes = uint64_t;
+
+constexpr uint32_t LANE_BITS = std::numeric_limits<Lanes>::digits;
+constexpr uint32_t LANE_WORDS = NYSA_LANE_WORDS;
+// Number of input combinations evaluated in one pass over the netlist
+constexpr uint64_t ROWS_PER_PASS = static_cast<uint64_t>(LANE_BITS) * LANE_WORDS;
+
+// Lanes of the six lowest bits of the input combination's number
+constexpr Lanes LOW_BITS_LANES[] = {
+    0xAAAAAAAAAAAAAAAA,
+    0xCCCCCCCCCCCCCCCC,
+    0xF0F0F0F0F0F0F0F0,
+    0xFF00FF00FF00FF00,
+    0xFFFF0000FFFF0000,
+    0xFFFFFFFF00000000
+};
+
+/**
+ * Returns the lanes of the start node which holds bit @p bit of the
+ * input combination's number, for the word starting at combination
+ * @p first_row (a multiple of @p LANE_BITS).
+ */
+inline Lanes start_node_lanes(uint32_t bit, uint64_t first_row) {
+    if (bit < std::size(LOW_BITS_LANES)) {
+        return LOW_BITS_LANES[bit];
+    }
+    if (bit < LANE_BITS && ((first_row >> bit) & 1) != 0) {
+        return ~Lanes{0};
+    }
+    return 0;
+}
+
+/**
+ * Sets the lanes of all start nodes for the pass starting at combination
+ * @p pass_row (a multiple of @p ROWS_PER_PASS). The first start node
+ * holds the most significant bit.
+ */
+inline void set_start_lanes(const Netlist &netlist, uint64_t pass_row, std::vector<Lanes> &lanes) {
+    const uint32_t number_of_start_nodes = get_start_nodes_count(netlist);
+    for (uint32_t i = 0; i < number_of_start_nodes; ++i) {
+        for (uint32_t w = 0; w < LANE_WORDS; ++w) {
+            lanes[std::size_t{i} * LANE_WORDS + w] = start_node_lanes(
+                number_of_start_nodes - 1 - i,
+                pass_row + static_cast<uint64_t>(w) * LANE_BITS
+            );
+        }
+    }
+}
+
+/**
+ * Computes all @p LANE_WORDS words of lanes of a gate from the lanes
+ * of its incoming nodes. The lanes of the node with dense index @p i
+ * start at @p lanes[i * LANE_WORDS].
+ */
+inline void compute_lanes(const Netlist &netlist, uint32_t node, std::vector<Lanes> &lanes) {
+    const std::vector<uint32_t> &fan_ins = get_fan_ins(netlist);
+    const uint32_t first_edge = get_fan_in_offsets(netlist)[node];
+    const uint32_t last_edge = get_fan_in_offsets(netlist)[node + 1];
+    const gate_type type = get_gate_types(netlist)[node];
+    Lanes *result = &lanes[std::size_t{node} * LANE_WORDS];
+    if (type == ZERO || type == ONE) {
+        std::fill(result, result + LANE_WORDS, type == ONE ? ~Lanes{0} : 0);
+        return;
+    }
+    const Lanes *first = &lanes[std::size_t{fan_ins[first_edge]} * LANE_WORDS];
+
+    std::copy(first, first + LANE_WORDS, result);
+    for (uint32_t e = first_edge + 1; e < last_edge; ++e) {
+        const Lanes *parent = &lanes[std::size_t{fan_ins[e]} * LANE_WORDS];
+        for (uint32_t w = 0; w < LANE_WORDS; ++w) {
+            switch (type) {
+                case XOR:
+                    result[w] ^= parent[w];
+                    break;
+                case AND:
+                case NAND:
+                    result[w] &= parent[w];
+                    break;
+                default:
+                    result[w] |= parent[w];
+                    break;
+            }
+        }
+    }
+
+    if (type == NOT || type == NAND || type == NOR) {
+        for (uint32_t w = 0; w < LANE_WORDS; ++w) {
+            result[w] = ~result[w];
+        }
+    }
+}
+
+/**
+ * Appends to @p output the rows number @p first_row to @p last_row,
+ * evaluating @p ROWS_PER_PASS consecutive permutations of start signals
+ * in every pass. @p evaluate_gates computes the lanes of all gates
+ * from the lanes of the start nodes.
+ */
+template <typename Evaluator>
+void lanes_simulation(const Netlist &netlist, uint64_t first_row, uint64_t last_row,
+                      std::string &output, const Evaluator &evaluate_gates)
+{
+    const std::vector<uint32_t> &displaying_order = get_displaying_order(netlist);
+
+    const std::size_t row_bytes = displaying_order.size() + 1;
+    std::vector<Lanes> lanes(std::size_t{get_nodes_count(netlist)} * LANE_WORDS);
+
+    for (uint64_t pass_row = first_row - first_row % ROWS_PER_PASS; ; pass_row += ROWS_PER_PASS) {
+        set_start_lanes(netlist, pass_row, lanes);
+        evaluate_gates(lanes);
+
+        // Transposing the lanes: every node fills its column in all rows of the pass
+        const uint64_t first_lane = std::max(first_row, pass_row) - pass_row;
+        const uint64_t last_lane = std::min(last_row - pass_row, ROWS_PER_PASS - 1);
+        char *rows = append_rows(netlist, output, last_lane - first_lane + 1);
+        for (std::size_t c = 0; c < displaying_order.size(); ++c) {
+            const Lanes *node_lanes = &lanes[std::size_t{displaying_order[c]} * LANE_WORDS];
+            char *cell = rows + c;
+            for (uint64_t r = first_lane; r <= last_lane; ++r, cell += row_bytes) {
+                *cell = static_cast<char>('0' + ((node_lanes[r / LANE_BITS] >> (r % LANE_BITS)) & 1));
+            }
+        }
+
+        if (last_row - pass_row < ROWS_PER_PASS) {
+            break;
+        }
+    }
+}
+
+/**
+ * Works like @p scalar_simulation, but evaluates @p ROWS_PER_PASS
+ * consecutive permutations of start signals in every pass over the
+ * netlist, keeping one bit per permutation in the lanes of every node.
+ */
+void bit_parallel_simulation(const Netlist &netlist, uint64_t first_row, uint64_t last_row,
+                             std::string &output)
+{
+    lanes_simulation(netlist, first_row, last_row, output, [&netlist](std::vector<Lanes> &lanes) {
+        for (uint32_t i = get_start_nodes_count(netlist); i < get_nodes_count(netlist); ++i) {
+            compute_lanes(netlist, i, lanes);
+        }
+    });
+}
+
+
+/********************************
+ *
+ *   MULTI-THREADED SIMULATION
+ *
+ ********************************/
+
+
+// Function appending the rows of the truth table with numbers from
+// the given range (inclusive) to the given string. Several threads may
+// call it at once.
+using Engine = std::function<void(uint64_t, uint64_t, std::string &)>;
+// Function preparing the engine simulating the given netlist, which may
+// use the given number of threads within a row
+using Engine_Factory = Engine (*)(const Netlist &, uint32_t);
+
+// Approximate size of the text of the rows simulated at once
+constexpr uint64_t CHUNK_BYTES = 1 << 20;
+// Number of simulated chunks per thread that may wait to be printed
+constexpr uint64_t REORDER_WINDOW = 4;
+
+/**
+ * Returns the number of rows simulated at once: a multiple of
+ * @p ROWS_PER_PASS taking about @p CHUNK_BYTES bytes of text.
+ */
+inline uint64_t rows_per_chunk(const Netlist &netlist) {
+    const uint64_t row_bytes = get_displaying_order(netlist).size() + 1;
+    return std::max<uint64_t>(CHUNK_BYTES / row_bytes / ROWS_PER_PASS, 1) * ROWS_PER_PASS;
+}
+
+/**
+ * Simulates the chunks number 0 to @p chunks - 1 with @p simulate_chunk,
+ * which fills the given buffer, and passes them to @p consume_chunk in
+ * order. With more than one thread the chunks are simulated by the workers
+ * independently (their simulation times add up); the chunks wait in
+ * a reorder buffer until all the preceding ones are consumed.
+ */
+template <typename Buffer, typename Simulator, typename Consumer>
+void ordered_chunks(uint64_t chunks, uint32_t threads, const Simulator &simulate_chunk,
+                    const Consumer &consume_chunk)
+{
+    if (threads <= 1) {
+        Buffer buffer;
+        for (uint64_t chunk = 0; chunk < chunks; ++chunk) {
+            const auto start = std::chrono::steady_clock::now();
+            simulate_chunk(chunk, buffer);
+            add_statistic(SIMULATE_NS, elapsed_ns(start));
+            consume_chunk(buffer);
+        }
+        return;
+    }
+
+    std::atomic<uint64_t> next_chunk = 0;
+    uint64_t next_consumed_chunk = 0;
+    // Simulated chunks waiting to be consumed
+    std::map<uint64_t, Buffer> reorder_buffer;
+    // Consumed chunks' buffers, reused to avoid reallocating them
+    std::vector<Buffer> free_buffers;
+    std::mutex mutex;
+    std::condition_variable chunk_simulated;
+    std::condition_variable chunk_consumed;
+
+    auto worker = [&]() {
+        for (uint64_t chunk = next_chunk++; chunk < chunks; chunk = next_chunk++) {
+            Buffer buffer;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                chunk_consumed.wait(lock, [&]() {
+                    return chunk < next_consumed_chunk + REORDER_WINDOW * threads;
+                });
+                if (not free_buffers.empty()) {
+                    buffer = std::move(free_buffers.back());
+                    free_buffers.pop_back();
+                }
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            simulate_chunk(chunk, buffer);
+            add_statistic(SIMULATE_NS, elapsed_ns(start));
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                reorder_buffer.emplace(chunk, std::move(buffer));
+            }
+            chunk_simulated.notify_one();
+        }
+    };
+
+    std::vector<std::jthread> workers;
+    for (uint32_t i = 0; i < threads; ++i) {
+        workers.emplace_back(worker);
+    }
+
+    for (uint64_t chunk = 0; chunk < chunks; ++chunk) {
+        Buffer buffer;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            chunk_simulated.wait(lock, [&]() {
+                return not reorder_buffer.empty() && reorder_buffer.begin()->first == chunk;
+            });
+            buffer = std::move(reorder_buffer.begin()->second);
+            reorder_buffer.erase(reorder_buffer.begin());
+            next_consumed_chunk = chunk + 1;
+        }
+        chunk_consumed.notify_all();
+        consume_chunk(buffer);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        free_buffers.push_back(std::move(buffer));
+    }
+}
+
+// Number of the first row which has not been printed yet + number of the
+// last row of the run + offset in the standard output just after the
+// printed rows, -1 if it is not a file
+using Checkpoint = std::tuple<uint64_t, uint64_t, int64_t>;
+
+/**
+ * Reads the checkpoint written by @p save_checkpoint. Returns an empty
+ * object if there is no valid checkpoint.
+ */
+std::optional<Checkpoint> load_checkpoint(const std::string &path) {
+    std::ifstream file(path);
+    std::string next_row;
+    std::string last_row;
+    int64_t offset;
+    if (not (file >> next_row >> last_row >> offset)) {
+        return {};
+    }
+
+    const std::optional<uint64_t> next = get_row_number(next_row);
+    const std::optional<uint64_t> last = get_row_number(last_row);
+    if (not next.has_value() || not last.has_value()) {
+        return {};
+    }
+    return Checkpoint{ next.value(), last.value(), offset };
+}
+
+/**
+ * Replaces the checkpoint at @p path, so that a run interrupted while
+ * writing it leaves the previous one intact. Saves the current offset
+ * in the standard output if @p out is @p std::cout.
+ */
+void save_checkpoint(const std::string &path, uint64_t next_row, uint64_t last_row, const std::ostream &out) {
+    const int64_t offset = &out == &std::cout ? lseek(STDOUT_FILENO, 0, SEEK_CUR) : -1;
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        if (not (file << next_row << ' ' << last_row << ' ' << offset << '\n' << std::flush)) {
+            return;
+        }
+    }
+    std::rename(temporary.c_str(), path.c_str());
+}
+
+/**
+ * Drops the rows printed to the standard output after the checkpoint
+ * was saved at @p offset, if the output is a regular file that has grown
+ * since, e.g. when the run was killed between printing a chunk and saving
+ * the checkpoint.
+ */
+void rewind_output(int64_t offset) {
+    struct stat output;
+    if (offset >= 0 && fstat(STDOUT_FILENO, &output) == 0 && S_ISREG(output.st_mode) && output.st_size > offset) {
+        if (ftruncate(STDOUT_FILENO, offset) == 0) {
+            lseek(STDOUT_FILENO, offset, SEEK_SET);
+        }
+    }
+}
+
+/**
+ * Prints to @p out the rows of the truth table of the netlist computed
+ * by @p engine, from the row number @p first_row to @p last_row, simulating
+ * the chunks of rows with @p threads threads. The chunks are aligned
+ * to multiples of their size, so the output of consecutive ranges adds
+ * up to the output of the whole range. Unless @p checkpoint is empty,
+ * every printed chunk is flushed and then the next row is saved there.
+ */
+void simulation(const Netlist &netlist, const Engine &engine, uint32_t threads, uint64_t first_row,
+                uint64_t last_row, const std::string &checkpoint, std::ostream &out)
+{
+    if (first_row > last_row) {
+        return;
+    }
+
+    const uint64_t chunk_rows = rows_per_chunk(netlist);
+    const uint64_t first_chunk = first_row / chunk_rows;
+    const uint64_t row_bytes = get_displaying_order(netlist).size() + 1;
+    uint64_t next_row = first_row;
+
+    auto simulate_chunk = [&](uint64_t chunk, std::string &output) {
+        const uint64_t chunk_row = (first_chunk + chunk) * chunk_rows;
+        output.clear();
+        engine(std::max(first_row, chunk_row), chunk_row + std::min(last_row - chunk_row, chunk_rows - 1), output);
+    };
+    auto print_chunk = [&](const std::string &output) {
+        const auto start = std::chrono::steady_clock::now();
+        out.write(output.data(), output.size());
+        next_row += output.size() / row_bytes;
+        if (not checkpoint.empty()) {
+            out.flush();
+            save_checkpoint(checkpoint, next_row, last_row, out);
+        }
+        add_statistic(PRINT_NS, elapsed_ns(start));
+        add_statistic(BYTES_WRITTEN, output.size());
+    };
+
+    ordered_chunks<std::string>(last_row / chunk_rows - first_chunk + 1, threads, simulate_chunk, print_chunk);
+}
+
+
+/********************************
+ *
+ *    INCREMENTAL SIMULATION
+ *
+ ********************************/
+
+
+// Offsets of the nodes' entries in the entry array (one more than
+// the number of nodes) + entries of consecutive nodes
+using Adjacency = std::pair<std::vector<uint32_t>, std::vector<uint32_t>>;
+
+/**
+ * Groups the entries by their nodes: entry @p i belongs to the node
+ * @p owners[i] and is stored as @p values[i].
+ */
+Adjacency group_by_node(uint32_t nodes, const std::vector<uint32_t> &owners,
+                        const std::vector<uint32_t> &values)
+{
+    std::vector<uint32_t> offsets(nodes + 1, 0);
+    std::vector<uint32_t> entries(owners.size());
+
+    for (auto owner : owners) {
+        ++offsets[owner + 1];
+    }
+    for (uint32_t i = 0; i < nodes; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+
+    std::vector<uint32_t> filled(offsets.begin(), offsets.end() - 1);
+    for (std::size_t i = 0; i < owners.size(); ++i) {
+        entries[filled[owners[i]]++] = values[i];
+    }
+
+    return { std::move(offsets), std::move(entries) };
+}
+
+/**
+ * Returns the fan-outs of the netlist's nodes.
+ */
+Adjacency get_fan_outs(const Netlist &netlist) {
+    std::vector<uint32_t> gates(get_fan_ins(netlist).size());
+    for (uint32_t node = 0; node < get_nodes_count(netlist); ++node) {
+        std::fill(gates.begin() + get_fan_in_offsets(netlist)[node],
+                  gates.begin() + get_fan_in_offsets(netlist)[node + 1], node);
+    }
+    return group_by_node(get_nodes_count(netlist), get_fan_ins(netlist), gates);
+}
+
+/**
+ * Returns the positions of the netlist's nodes in the row. An optimised
+ * netlist may display one node in several columns.
+ */
+Adjacency get_columns(const Netlist &netlist) {
+    std::vector<uint32_t> columns(get_displaying_order(netlist).size());
+    for (uint32_t c = 0; c < columns.size(); ++c) {
+        columns[c] = c;
+    }
+    return group_by_node(get_nodes_count(netlist), get_displaying_order(netlist), columns);
+}
+
+/**
+ * Works like @p scalar_simulation, but goes through the permutations
+ * in blocks of 2^k rows, ordering the rows inside a block by the Gray code
+ * of their lowest k bits, so that only one start signal changes between
+ * consecutive rows. After every change only the gates whose inputs have
+ * changed are re-evaluated, in the simulation order. The rows are formatted
+ * into their places in a block buffer and appended to @p output
+ * in the order of their numbers.
+ */
+void incremental_simulation(const Netlist &netlist, const Adjacency &fan_out_lists,
+                            const Adjacency &column_lists, uint64_t first_row, uint64_t last_row,
+                            std::string &output)
+{
+    const uint32_t number_of_start_nodes = get_start_nodes_count(netlist);
+    const std::vector<uint32_t> &displaying_order = get_displaying_order(netlist);
+    const auto &[fan_out_offsets, fan_outs] = fan_out_lists;
+    const auto &[column_offsets, columns] = column_lists;
+    const uint64_t row_bytes = displaying_order.size() + 1;
+
+    // The block holds at most CHUNK_BYTES of text, and its size divides
+    // the size of the chunks, so that the chunks start at its beginning
+    const uint32_t block_bits = std::min<uint32_t>({
+        static_cast<uint32_t>(std::bit_width(std::max<uint64_t>(CHUNK_BYTES / row_bytes, 1)) - 1),
+        static_cast<uint32_t>(std::countr_zero(rows_per_chunk(netlist))),
+        number_of_start_nodes
+    });
+    const uint64_t block_rows = uint64_t{1} << block_bits;
+    std::string block(block_rows * row_bytes, '\n');
+
+    Signals signals(get_nodes_count(netlist), 0);
+    std::string row(displaying_order.size(), '0');
+    // Gates waiting for re-evaluation, the earliest in the simulation order first
+    std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> queue;
+    std::vector<uint8_t> queued(get_nodes_count(netlist), 0);
+
+    auto schedule_fan_outs = [&](uint32_t node) {
+        for (uint32_t e = fan_out_offsets[node]; e < fan_out_offsets[node + 1]; ++e) {
+            if (not queued[fan_outs[e]]) {
+                queued[fan_outs[e]] = 1;
+                queue.push(fan_outs[e]);
+            }
+        }
+    };
+    auto set_signal = [&](uint32_t node, bool signal) {
+        if (signals[node] != signal) {
+            signals[node] = signal;
+            for (uint32_t c = column_offsets[node]; c < column_offsets[node + 1]; ++c) {
+                row[columns[c]] = signal ? '1' : '0';
+            }
+            schedule_fan_outs(node);
+        }
+    };
+    auto propagate = [&]() {
+        while (not queue.empty()) {
+            const uint32_t node = queue.top();
+            queue.pop();
+            queued[node] = 0;
+            set_signal(node, compute_signal_val(netlist, signals, node));
+        }
+    };
+
+    // All the signals are zero now, so every gate has to be evaluated once
+    for (uint32_t i = number_of_start_nodes; i < get_nodes_count(netlist); ++i) {
+        queued[i] = 1;
+        queue.push(i);
+    }
+
+    for (uint64_t block_row = first_row - first_row % block_rows; ; block_row += block_rows) {
+        for (uint64_t i = 0; i < block_rows; ++i) {
+            if (i == 0) {
+                for (uint32_t node = 0; node < number_of_start_nodes; ++node) {
+                    set_signal(node, start_signal(netlist, node, block_row));
+                }
+            }
+            else {
+                // The lowest set bit of i is the one that differs in the Gray codes of i - 1 and i
+                const uint32_t node = number_of_start_nodes - 1 - std::countr_zero(i);
+                set_signal(node, not signals[node]);
+            }
+            propagate();
+
+            const uint64_t gray_code = i ^ (i >> 1);
+            std::copy(row.begin(), row.end(), block.begin() + gray_code * row_bytes);
+        }
+
+        const uint64_t first_copied = std::max(first_row, block_row) - block_row;
+        const uint64_t last_copied = std::min(last_row - block_row, block_rows - 1);
+        output.append(block, first_copied * row_bytes, (last_copied - first_copied + 1) * row_bytes);
+
+        if (last_row - block_row < block_rows) {
+            break;
+        }
+    }
+}
+
+
+/********************************
+ *
+ *     BYTECODE INTERPRETER
+ *
+ ********************************/
+
+
+// Instructions of the bytecode. Every instruction is followed by the number
+// of gates it evaluates one after another and the operands of each gate,
+// so the dispatch happens once per run of gates of the same kind.
+enum opcode : uint32_t {
+    OP_NOT,         // result, input
+    OP_XOR,         // result, two inputs
+    OP_AND2,        // result, two inputs
+    OP_NAND2,       // result, two inputs
+    OP_OR2,         // result, two inputs
+    OP_NOR2,        // result, two inputs
+    OP_HALF_ADDER,  // XOR's result, AND's result, the same two inputs of both
+    OP_AND,         // result, number of inputs, inputs
+    OP_NAND,        // result, number of inputs, inputs
+    OP_OR,          // result, number of inputs, inputs
+    OP_NOR,         // result, number of inputs, inputs
+    OP_ZERO,        // result
+    OP_ONE          // result
+};
+
+/**
+ * Returns the level of every node of the netlist: 0 for the start nodes,
+ * one more than the highest level of the gate's inputs for gates.
+ */
+std::vector<uint32_t> get_levels(const Netlist &netlist) {
+    std::vector<uint32_t> levels(get_nodes_count(netlist), 0);
+    for (uint32_t node = get_start_nodes_count(netlist); node < get_nodes_count(netlist); ++node) {
+        for (uint32_t e = get_fan_in_offsets(netlist)[node]; e < get_fan_in_offsets(netlist)[node + 1]; ++e) {
+            levels[node] = std::max(levels[node], levels[get_fan_ins(netlist)[e]] + 1);
+        }
+    }
+    return levels;
+}
+
+/**
+ * Returns the instruction evaluating the gate on its own.
+ */
+inline opcode gate_opcode(gate_type type, uint32_t inputs) {
+    switch (type) {
+        case NOT:
+            return OP_NOT;
+        case XOR:
+            return OP_XOR;
+        case AND:
+            return inputs == 2 ? OP_AND2 : OP_AND;
+        case NAND:
+            return inputs == 2 ? OP_NAND2 : OP_NAND;
+        case OR:
+            return inputs == 2 ? OP_OR2 : OP_OR;
+        case NOR:
+            return inputs == 2 ? OP_NOR2 : OP_NOR;
+        case ONE:
+            return OP_ONE;
+        default:
+#ifdef DEBUG
+            assert(type == ZERO);
+#endif
+            return OP_ZERO;
+    }
+}
+
+/**
+ * Translates the netlist into the bytecode. The gates are grouped by their
+ * levels, and within a level by their instructions, so that the gates of
+ * the same kind form long runs. An @p XOR and an @p AND over the same two
+ * inputs (a half adder) are fused into one instruction.
+ */
+std::vector<uint32_t> compile_bytecode(const Netlist &netlist) {
+    const std::vector<uint32_t> levels = get_levels(netlist);
+    const std::vector<gate_type> &types = get_gate_types(netlist);
+    const std::vector<uint32_t> &offsets = get_fan_in_offsets(netlist);
+    const std::vector<uint32_t> &fan_ins = get_fan_ins(netlist);
+
+    std::vector<opcode> opcodes(get_nodes_count(netlist));
+    // The AND fused with every XOR of a half adder (or the XOR itself)
+    std::vector<uint32_t> partner(get_nodes_count(netlist));
+    // Unfused two-input ANDs by their sorted inputs
+    std::map<std::pair<uint32_t, uint32_t>, std::vector<uint32_t>> two_input_ands;
+    std::vector<uint32_t> gates;
+
+    for (uint32_t node = get_start_nodes_count(netlist); node < get_nodes_count(netlist); ++node) {
+        opcodes[node] = gate_opcode(types[node], offsets[node + 1] - offsets[node]);
+        partner[node] = node;
+        if (opcodes[node] == OP_AND2) {
+            two_input_ands[std::minmax(fan_ins[offsets[node]], fan_ins[offsets[node] + 1])].push_back(node);
+        }
+    }
+
+    for (uint32_t node = get_start_nodes_count(netlist); node < get_nodes_count(netlist); ++node) {
+        if (opcodes[node] == OP_XOR) {
+            const auto ands = two_input_ands.find(std::minmax(fan_ins[offsets[node]], fan_ins[offsets[node] + 1]));
+            if (ands != two_input_ands.end() && not ands->second.empty()) {
+                opcodes[node] = OP_HALF_ADDER;
+                partner[node] = ands->second.back();
+                partner[ands->second.back()] = node;
+                ands->second.pop_back();
+            }
+        }
+    }
+
+    for (uint32_t node = get_start_nodes_count(netlist); node < get_nodes_count(netlist); ++node) {
+        // A fused AND is evaluated by its XOR's instruction
+        if (opcodes[node] != OP_AND2 || partner[node] == node) {
+            gates.push_back(node);
+        }
+    }
+
+    std::stable_sort(gates.begin(), gates.end(), [&](uint32_t a, uint32_t b) {
+        return std::make_pair(levels[a], opcodes[a]) < std::make_pair(levels[b], opcodes[b]);
+    });
+
+    std::vector<uint32_t> program;
+    for (std::size_t run = 0; run < gates.size(); ) {
+        const opcode instruction = opcodes[gates[run]];
+        std::size_t run_end = run;
+        while (run_end < gates.size() && opcodes[gates[run_end]] == instruction
+               && levels[gates[run_end]] == levels[gates[run]]) {
+            ++run_end;
+        }
+
+        program.push_back(instruction);
+        program.push_back(run_end - run);
+        for (; run < run_end; ++run) {
+            const uint32_t gate = gates[run];
+            program.push_back(gate);
+            if (instruction == OP_HALF_ADDER) {
+                program.push_back(partner[gate]);
+            }
+            if (instruction >= OP_AND && instruction <= OP_NOR) {
+                program.push_back(offsets[gate + 1] - offsets[gate]);
+            }
+            program.insert(program.end(), fan_ins.begin() + offsets[gate], fan_ins.begin() + offsets[gate + 1]);
+        }
+    }
+
+    return program;
+}
+
+/**
+ * Evaluates a run of @p count gates with two inputs each, computing
+ * the lanes of the result with @p operation. Returns the position
+ * of the next instruction.
+ */
+template <typename Operation>
+inline const uint32_t *run_binary(const uint32_t *pc, uint32_t count, Lanes *lanes,
+                                  const Operation &operation)
+{
+    for (uint32_t g = 0; g < count; ++g, pc += 3) {
+        Lanes *result = lanes + std::size_t{pc[0]} * LANE_WORDS;
+        const Lanes *a = lanes + std::size_t{pc[1]} * LANE_WORDS;
+        const Lanes *b = lanes + std::size_t{pc[2]} * LANE_WORDS;
+        for (uint32_t w = 0; w < LANE_WORDS; ++w) {
+            result[w] = operation(a[w], b[w]);
+        }
+    }
+    return pc;
+}
+
+/**
+ * Evaluates a run of @p count gates with any number of inputs,
+ * folding their lanes with @p operation and negating the result
+ * if @p negated. Returns the position of the next instruction.
+ */
+template <typename Operation>
+inline const uint32_t *run_n_ary(const uint32_t *pc, uint32_t count, Lanes *lanes,
+                                 const Operation &operation, bool negated)
+{
+    for (uint32_t g = 0; g < count; ++g) {
+        Lanes *result = lanes + std::size_t{pc[0]} * LANE_WORDS;
+        const uint32_t inputs = pc[1];
+        const Lanes *first = lanes + std::size_t{pc[2]} * LANE_WORDS;
+        std::copy(first, first + LANE_WORDS, result);
+        for (uint32_t i = 1; i < inputs; ++i) {
+            const Lanes *input = lanes + std::size_t{pc[2 + i]} * LANE_WORDS;
+            for (uint32_t w = 0; w < LANE_WORDS; ++w) {
+                result[w] = operation(result[w], input[w]);
+            }
+        }
+        if (negated) {
+            for (uint32_t w = 0; w < LANE_WORDS; ++w) {
+                result[w] = ~result[w];
+            }
+        }
+        pc += 2 + inputs;
+    }
+    return pc;
+}
+
+/**
+ * Executes the bytecode, computing the lanes of all gates
+ * from the lanes of the start nodes.
+ */
+void run_bytecode(const std::vector<uint32_t> &program, std::vector<Lanes> &node_lanes) {
+    Lanes *lanes = node_lanes.data();
+    const uint32_t *pc = program.data();
+    const uint32_t *end = program.data() + program.size();
+    const auto bit_and = [](Lanes a, Lanes b) { return a & b; };
+    const auto bit_or = [](Lanes a, Lanes b) { return a | b; };
+
+    while (pc < end) {
+        const uint32_t instruction = pc[0];
+        const uint32_t count = pc[1];
+        pc += 2;
+
+        switch (instruction) {
+            case OP_NOT:
+                for (uint32_t g = 0; g < count; ++g, pc += 2) {
+                    Lanes *result = lanes + std::size_t{pc[0]} * LANE_WORDS;
+                    const Lanes *input = lanes + std::size_t{pc[1]} * LANE_WORDS;
+                    for (uint32_t w = 0; w < LANE_WORDS; ++w) {
+                        result[w] = ~input[w];
+                    }
+                }
+                break;
+            case OP_XOR:
+                pc = run_binary(pc, count, lanes, [](Lanes a, Lanes b) { return a ^ b; });
+                break;
+            case OP_AND2:
+                pc = run_binary(pc, count, lanes, bit_and);
+                break;
+            case OP_NAND2:
+                pc = run_binary(pc, count, lanes, [](Lanes a, Lanes b) { return ~(a & b); });
+                break;
+            case OP_OR2:
+                pc = run_binary(pc, count, lanes, bit_or);
+                break;
+            case OP_NOR2:
+                pc = run_binary(pc, count, lanes, [](Lanes a, Lanes b) { return ~(a | b); });
+                break;
+            case OP_HALF_ADDER:
+                for (uint32_t g = 0; g < count; ++g, pc += 4) {
+                    Lanes *sum = lanes + std::size_t{pc[0]} * LANE_WORDS;
+                    Lanes *carry = lanes + std::size_t{pc[1]} * LANE_WORDS;
+                    const Lanes *a = lanes + std::size_t{pc[2]} * LANE_WORDS;
+                    const Lanes *b = lanes + std::size_t{pc[3]} * LANE_WORDS;
+                    for (uint32_t w = 0; w < LANE_WORDS; ++w) {
+                        sum[w] = a[w] ^ b[w];
+                        carry[w] = a[w] & b[w];
+                    }
+                }
+                break;
+            case OP_AND:
+            case OP_NAND:
+                pc = run_n_ary(pc, count, lanes, bit_and, instruction == OP_NAND);
+                break;
+            case OP_OR:
+            case OP_NOR:
+                pc = run_n_ary(pc, count, lanes, bit_or, instruction == OP_NOR);
+                break;
+            case OP_ZERO:
+            case OP_ONE:
+                for (uint32_t g = 0; g < count; ++g, ++pc) {
+                    Lanes *result = lanes + std::size_t{pc[0]} * LANE_WORDS;
+                    std::fill(result, result + LANE_WORDS, instruction == OP_ONE ? ~Lanes{0} : 0);
+                }
+                break;
+            default:
+#ifdef DEBUG
+                assert(false);
+#endif
+                return;
+        }
+    }
+}
+
+/**
+ * Works like @p bit_parallel_simulation, but evaluates the gates
+ * by executing the netlist's bytecode.
+ */
+void bytecode_simulation(const Netlist &netlist, const std::vector<uint32_t> &program,
+                         uint64_t first_row, uint64_t last_row, std::string &output)
+{
+    lanes_simulation(netlist, first_row, last_row, output, [&program](std::vector<Lanes> &lanes) {
+        run_bytecode(program, lanes);
+    });
+}
+
+
+/********************************
+ *
+ *     WAVEFRONT SIMULATION
+ *
+ ********************************/
+
+
+/**
+ * Groups the gates of the netlist by their levels and splits every level
+ * between @p threads threads: part number level * @p threads + thread
+ * holds the gates of the level evaluated by the thread. The gates of one
+ * level depend only on the lower levels, so they can be evaluated in any
+ * order.
+ */
+Adjacency get_wavefronts(const Netlist &netlist, uint32_t threads) {
+    const std::vector<uint32_t> levels = get_levels(netlist);
+    std::vector<uint32_t> gate_levels(levels.begin() + get_start_nodes_count(netlist), levels.end());
+    std::vector<uint32_t> gates(gate_levels.size());
+    for (uint32_t g = 0; g < gates.size(); ++g) {
+        gates[g] = get_start_nodes_count(netlist) + g;
+    }
+
+    const uint32_t number_of_levels = gate_levels.empty()
+                                      ? 0 : *std::max_element(gate_levels.begin(), gate_levels.end()) + 1;
+    auto [level_offsets, level_gates] = group_by_node(number_of_levels, gate_levels, gates);
+
+    std::vector<uint32_t> part_offsets(1, 0);
+    part_offsets.reserve(static_cast<std::size_t>(number_of_levels) * threads + 1);
+    for (uint32_t level = 0; level < number_of_levels; ++level) {
+        const uint64_t level_size = level_offsets[level + 1] - level_offsets[level];
+        for (uint32_t thread = 0; thread < threads; ++thread) {
+            part_offsets.push_back(level_offsets[level] + level_size * (thread + 1) / threads);
+        }
+    }
+    return { std::move(part_offsets), std::move(level_gates) };
+}
+
+// Threads of the wavefront engine, started once and kept for all its
+// chunks: the parts of the levels + number of threads + barrier after
+// every level + lanes of the current pass (nullptr once the engine is
+// destroyed) + workers, i.e. all the threads but the simulating one
+using Wavefront_Pool = std::tuple<Adjacency, uint32_t, std::barrier<>, std::vector<Lanes> *,
+                                  std::vector<std::jthread>>;
+
+/**
+ * Evaluates the parts of all levels of the pool's netlist assigned to
+ * the thread number @p thread, waiting for the other threads after every
+ * level.
+ */
+void evaluate_wavefronts(const Netlist &netlist, Wavefront_Pool &pool, uint32_t thread, std::vector<Lanes> &lanes) {
+    const auto &[part_offsets, gates] = std::get<0>(pool);
+    const uint32_t threads = std::get<1>(pool);
+    for (uint32_t part = thread; part + 1 < part_offsets.size(); part += threads) {
+        for (uint32_t g = part_offsets[part]; g < part_offsets[part + 1]; ++g) {
+            compute_lanes(netlist, gates[g], lanes);
+        }
+        std::get<2>(pool).arrive_and_wait();
+    }
+}
+
+/**
+ * Splits the levels of the netlist between @p threads threads and starts
+ * all but one of them, waiting for the passes of @p wavefront_simulation.
+ * The workers are stopped and joined when the last copy of the pool is
+ * destroyed.
+ */
+std::shared_ptr<Wavefront_Pool> start_wavefront_pool(const Netlist &netlist, uint32_t threads) {
+    // The workers read the pass's lanes after the start of a pass, and the
+    // simulating thread can change them only after the barrier of the
+    // pass's first level, so without levels (e.g. with all the gates
+    // folded) there's nothing to share
+    if (get_nodes_count(netlist) == get_start_nodes_count(netlist)) {
+        threads = 1;
+    }
+
+    std::shared_ptr<Wavefront_Pool> pool(
+        new Wavefront_Pool(get_wavefronts(netlist, threads), threads, threads, nullptr, std::vector<std::jthread>()),
+        [](Wavefront_Pool *pool) {
+            // Releasing the workers waiting for a pass, with no lanes
+            std::get<3>(*pool) = nullptr;
+            std::get<2>(*pool).arrive_and_wait();
+            std::get<4>(*pool).clear();
+            delete pool;
+        });
+
+    for (uint32_t thread = 1; thread < threads; ++thread) {
+        std::get<4>(*pool).emplace_back([&netlist, &pool = *pool, thread]() {
+            std::barrier<> &level_done = std::get<2>(pool);
+            std::vector<Lanes> *const &pass_lanes = std::get<3>(pool);
+            // Waiting for the start nodes' lanes of every pass
+            for (level_done.arrive_and_wait(); pass_lanes != nullptr; level_done.arrive_and_wait()) {
+                evaluate_wavefronts(netlist, pool, thread, *pass_lanes);
+            }
+        });
+    }
+    return pool;
+}
+
+/**
+ * Works like @p bit_parallel_simulation, but evaluates every level of the
+ * netlist with all threads of the @p pool, so that a single row of a large
+ * and shallow netlist is evaluated in parallel. The threads wait for each
+ * other at a barrier after every level, and between the chunks the workers
+ * wait for the next pass.
+ */
+void wavefront_simulation(const Netlist &netlist, Wavefront_Pool &pool,
+                          uint64_t first_row, uint64_t last_row, std::string &output)
+{
+    lanes_simulation(netlist, first_row, last_row, output, [&](std::vector<Lanes> &lanes) {
+        std::get<3>(pool) = &lanes;
+        std::get<2>(pool).arrive_and_wait();
+        evaluate_wavefronts(netlist, pool, 0, lanes);
+    });
+}
+
+
+/********************************
+ *
+ *     STREAMING SIMULATION
+ *
+ ********************************/
+
+
+// Rows of the truth table delivered at once: number of the first row
+// + number of rows + values of the displayed signals, in the increasing
+// order of their indices, packed one per bit into columns of equal
+// numbers of words (the first row in the lowest bit of the first word)
+using Row_Batch = std::tuple<uint64_t, uint64_t, std::vector<Lanes>>;
+// Function receiving the batches of rows in the order of the rows
+using Row_Consumer = std::function<void(const Row_Batch &)>;
+
+inline uint64_t get_batch_first_row(const Row_Batch &batch) {
+    return std::get<0>(batch);
+}
+
+inline uint64_t get_batch_rows(const Row_Batch &batch) {
+    return std::get<1>(batch);
+}
+
+inline uint64_t get_column_words(const Row_Batch &batch) {
+    return (get_batch_rows(batch) + LANE_BITS - 1) / LANE_BITS;
+}
+
+/**
+ * Returns the values of the displayed signal number @p column
+ * in the rows of the batch.
+ */
+inline std::span<const Lanes> get_column(const Row_Batch &batch, std::size_t column) {
+    return { std::get<2>(batch).data() + column * get_column_words(batch), get_column_words(batch) };
+}
+
+/**
+ * Fills @p batch with the rows number @p first_row to @p last_row,
+ * evaluating the gates by executing the netlist's bytecode. The lanes
+ * are copied word by word, shifted if @p first_row is not a multiple
+ * of @p LANE_BITS.
+ */
+void pack_rows(const Netlist &netlist, const std::vector<uint32_t> &program, uint64_t first_row,
+               uint64_t last_row, Row_Batch &batch)
+{
+    const std::vector<uint32_t> &displaying_order = get_displaying_order(netlist);
+    std::get<0>(batch) = first_row;
+    std::get<1>(batch) = last_row - first_row + 1;
+    const uint64_t words = get_column_words(batch);
+    std::vector<Lanes> &columns = std::get<2>(batch);
+    columns.assign(displaying_order.size() * words, 0);
+    std::vector<Lanes> lanes(std::size_t{get_nodes_count(netlist)} * LANE_WORDS);
+
+    const uint32_t shift = first_row % LANE_BITS;
+    for (uint64_t pass_row = first_row - first_row % ROWS_PER_PASS; ; pass_row += ROWS_PER_PASS) {
+        set_start_lanes(netlist, pass_row, lanes);
+        run_bytecode(program, lanes);
+
+        for (uint32_t w = 0; w < LANE_WORDS && pass_row + w * LANE_BITS <= last_row; ++w) {
+            const uint64_t word_row = pass_row + w * LANE_BITS;
+            if (word_row + LANE_BITS <= first_row) {
+                continue;
+            }
+            const uint64_t word = (word_row - (first_row - shift)) / LANE_BITS;
+            for (std::size_t c = 0; c < displaying_order.size(); ++c) {
+                const Lanes node_lanes = lanes[std::size_t{displaying_order[c]} * LANE_WORDS + w];
+                Lanes *column = &columns[c * words];
+                if (word < words) {
+                    column[word] |= node_lanes >> shift;
+                }
+                if (shift != 0 && word > 0) {
+                    column[word - 1] |= node_lanes << (LANE_BITS - shift);
+                }
+            }
+        }
+
+        if (last_row - pass_row < ROWS_PER_PASS) {
+            break;
+        }
+    }
+
+    // Clearing the bits after the last row
+    if (get_batch_rows(batch) % LANE_BITS != 0) {
+        const Lanes mask = (Lanes{1} << get_batch_rows(batch) % LANE_BITS) - 1;
+        for (std::size_t c = 0; c < displaying_order.size(); ++c) {
+            columns[c * words + words - 1] &= mask;
+        }
+    }
+}
+
+/**
+ * Appends the rows of the batch to @p output as text.
+ */
+void format_batch(const Netlist &netlist, const Row_Batch &batch, std::string &output) {
+    const std::size_t row_bytes = get_displaying_order(netlist).size() + 1;
+    char *rows = append_rows(netlist, output, get_batch_rows(batch));
+    for (std::size_t c = 0; c + 1 < row_bytes; ++c) {
+        const std::span<const Lanes> column = get_column(batch, c);
+        char *cell = rows + c;
+        for (uint64_t r = 0; r < get_batch_rows(batch); ++r, cell += row_bytes) {
+            *cell = static_cast<char>('0' + ((column[r / LANE_BITS] >> (r % LANE_BITS)) & 1));
+        }
+    }
+}
+
+/**
+ * Passes the rows of the truth table of the netlist from the row number
+ * @p first_row to @p last_row to @p consume_batch, in batches aligned like
+ * the chunks of @p simulation and simulated with @p threads threads.
+ * Unlike @p simulation, the rows are never formatted as text.
+ */
+void stream_simulation(const Netlist &netlist, uint32_t threads, uint64_t first_row, uint64_t last_row,
+                       const Row_Consumer &consume_batch)
+{
+    if (first_row > last_row) {
+        return;
+    }
+
+    const std::vector<uint32_t> program = compile_bytecode(netlist);
+    const uint64_t chunk_rows = rows_per_chunk(netlist);
+    const uint64_t first_chunk = first_row / chunk_rows;
+    auto simulate_chunk = [&](uint64_t chunk, Row_Batch &batch) {
+        const uint64_t chunk_row = (first_chunk + chunk) * chunk_rows;
+        pack_rows(netlist, program, std::max(first_row, chunk_row),
+                  chunk_row + std::min(last_row - chunk_row, chunk_rows - 1), batch);
+    };
+
+    ordered_chunks<Row_Batch>(last_row / chunk_rows - first_chunk + 1, threads, simulate_chunk, consume_batch);
+}
+
+
+/********************************
+ *
+ *       SIGNAL ACTIVITY
+ *
+ ********************************/
+
+
+/**
+ * Prints for every displayed signal, in the increasing order of indices,
+ * the number of rows from @p first_row to @p last_row in which it is 1 and
+ * the number of changes of its value between consecutive rows, followed
+ * by both numbers relative to the numbers of rows and of pairs of rows.
+ * The values are counted on the packed rows, without printing them.
+ */
+void activity_simulation(const Netlist &netlist, uint32_t threads, uint64_t first_row, uint64_t last_row,
+                         std::ostream &out)
+{
+    const std::vector<uint32_t> &displayed_IDs = get_displayed_IDs(netlist);
+    std::vector<uint64_t> ones(displayed_IDs.size(), 0);
+    std::vector<uint64_t> toggles(displayed_IDs.size(), 0);
+    // Values of the signals in the last row of the previous batch
+    std::vector<uint8_t> last_values(displayed_IDs.size(), 0);
+    uint64_t rows = 0;
+
+    stream_simulation(netlist, threads, first_row, last_row, [&](const Row_Batch &batch) {
+        const uint64_t words = get_column_words(batch);
+        const uint64_t batch_rows = get_batch_rows(batch);
+        // Changes after the last row of the batch are not counted
+        const Lanes last_word_changes = (Lanes{1} << ((batch_rows - 1) % LANE_BITS)) - 1;
+
+        for (std::size_t c = 0; c < displayed_IDs.size(); ++c) {
+            const std::span<const Lanes> column = get_column(batch, c);
+            uint64_t column_ones = 0;
+            uint64_t column_toggles = rows > 0 && (column[0] & 1) != last_values[c];
+            for (uint64_t w = 0; w < words; ++w) {
+                // Bit i holds the value in the row after the one of bit i of the column
+                const Lanes next = (column[w] >> 1) | (w + 1 < words ? column[w + 1] << (LANE_BITS - 1) : 0);
+                const Lanes changes = column[w] ^ next;
+                column_ones += std::popcount(column[w]);
+                column_toggles += std::popcount(w + 1 < words ? changes : changes & last_word_changes);
+            }
+            ones[c] += column_ones;
+            toggles[c] += column_toggles;
+            last_values[c] = (column[words - 1] >> ((batch_rows - 1) % LANE_BITS)) & 1;
+        }
+        rows += batch_rows;
+    });
+
+    std::string output;
+    for (std::size_t c = 0; c < displayed_IDs.size(); ++c) {
+        char rates[64];
+        std::snprintf(rates, sizeof(rates), " %.6f %.6f\n",
+                      rows > 0 ? static_cast<double>(ones[c]) / rows : 0.0,
+                      rows > 1 ? static_cast<double>(toggles[c]) / (rows - 1) : 0.0);
+        output += std::to_string(displayed_IDs[c]) + ' ' + std::to_string(ones[c]) + ' '
+                  + std::to_string(toggles[c]) + rates;
+    }
+    out.write(output.data(), output.size());
+}
+
+
+/********************************
+ *
+ *  BINARY DECISION DIAGRAMS
+ *
+ ********************************/
+
+
+// Variable of the node (its position in the variable order) + node taken
+// when the variable is 0 + node taken when it is 1. Nodes 0 and 1 are the
+// constant functions, their variable is the number of variables.
+using Bdd_Node = std::tuple<uint32_t, uint32_t, uint32_t>;
+
+// Operations on the diagrams
+enum bdd_operation : uint8_t {
+    BDD_AND,
+    BDD_OR,
+    BDD_XOR
+};
+
+// Operation + its two arguments + its result
+using Bdd_Cache_Entry = std::tuple<bdd_operation, uint32_t, uint32_t, uint32_t>;
+
+// Nodes of all diagrams + open-addressing table of the nodes (indices,
+// 0 for empty slots) + direct-mapped cache of operations + start node
+// of every variable
+using Bdd = std::tuple<std::vector<Bdd_Node>, std::vector<uint32_t>, std::vector<Bdd_Cache_Entry>,
+                       std::vector<uint32_t>>;
+
+constexpr uint32_t BDD_FALSE = 0;
+constexpr uint32_t BDD_TRUE = 1;
+// Number of slots of the cache of operations
+constexpr std::size_t BDD_CACHE_SIZE = std::size_t{1} << 18;
+// Limit on the number of nodes, reached by circuits such as multipliers
+// for which the diagrams grow exponentially
+constexpr std::size_t BDD_NODES_LIMIT = std::size_t{1} << 22;
+// Result of the operations which would exceed the limit
+constexpr uint32_t BDD_OVERFLOW = std::numeric_limits<uint32_t>::max();
+
+inline std::vector<Bdd_Node> &get_bdd_nodes(Bdd &bdd) {
+    return std::get<0>(bdd);
+}
+
+inline const std::vector<Bdd_Node> &get_bdd_nodes(const Bdd &bdd) {
+    return std::get<0>(bdd);
+}
+
+inline uint32_t bdd_variable(const Bdd &bdd, uint32_t node) {
+    return std::get<0>(get_bdd_nodes(bdd)[node]);
+}
+
+inline uint32_t bdd_low(const Bdd &bdd, uint32_t node) {
+    return std::get<1>(get_bdd_nodes(bdd)[node]);
+}
+
+inline uint32_t bdd_high(const Bdd &bdd, uint32_t node) {
+    return std::get<2>(get_bdd_nodes(bdd)[node]);
+}
+
+inline const std::vector<uint32_t> &get_variable_order(const Bdd &bdd) {
+    return std::get<3>(bdd);
+}
+
+inline uint64_t bdd_hash(uint64_t a, uint64_t b, uint64_t c) {
+    uint64_t hash = (a * 0x9E3779B97F4A7C15) ^ (b * 0xC2B2AE3D27D4EB4F) ^ (c * 0x165667B19E3779F9);
+    return hash ^ (hash >> 29);
+}
+
+/**
+ * Returns the node testing @p variable with the given successors,
+ * creating it if it does not exist yet. Returns @p low if both
+ * successors are the same, and @p BDD_OVERFLOW if a successor is
+ * @p BDD_OVERFLOW or a new node would exceed @p BDD_NODES_LIMIT.
+ */
+uint32_t bdd_node(Bdd &bdd, uint32_t variable, uint32_t low, uint32_t high) {
+    if (low == BDD_OVERFLOW || high == BDD_OVERFLOW) {
+        return BDD_OVERFLOW;
+    }
+    if (low == high) {
+        return low;
+    }
+
+    std::vector<Bdd_Node> &nodes = get_bdd_nodes(bdd);
+    std::vector<uint32_t> &table = std::get<1>(bdd);
+    std::size_t slot = bdd_hash(variable, low, high) & (table.size() - 1);
+    for (; table[slot] != 0; slot = (slot + 1) & (table.size() - 1)) {
+        if (nodes[table[slot]] == Bdd_Node{ variable, low, high }) {
+            return table[slot];
+        }
+    }
+
+    if (nodes.size() >= BDD_NODES_LIMIT) {
+        return BDD_OVERFLOW;
+    }
+    nodes.emplace_back(variable, low, high);
+    table[slot] = nodes.size() - 1;
+
+    // Keeping the table at most half full
+    if (2 * nodes.size() > table.size()) {
+        std::vector<uint32_t> larger(2 * table.size(), 0);
+        for (uint32_t node = BDD_TRUE + 1; node < nodes.size(); ++node) {
+            const auto &[v, l, h] = nodes[node];
+            std::size_t s = bdd_hash(v, l, h) & (larger.size() - 1);
+            while (larger[s] != 0) {
+                s = (s + 1) & (larger.size() - 1);
+            }
+            larger[s] = node;
+        }
+        table = std::move(larger);
+    }
+
+    return nodes.size() - 1;
+}
+
+/**
+ * Returns the diagram of @p operation applied to the diagrams @p a and @p b,
+ * or @p BDD_OVERFLOW as soon as it would need more than @p BDD_NODES_LIMIT
+ * nodes.
+ */
+uint32_t bdd_apply(Bdd &bdd, bdd_operation operation, uint32_t a, uint32_t b) {
+    if (a == BDD_OVERFLOW || b == BDD_OVERFLOW) {
+        return BDD_OVERFLOW;
+    }
+    switch (operation) {
+        case BDD_AND:
+            if (a == BDD_FALSE || b == BDD_FALSE) {
+                return BDD_FALSE;
+            }
+            if (a == BDD_TRUE || a == b) {
+                return b;
+            }
+            if (b == BDD_TRUE) {
+                return a;
+            }
+            break;
+        case BDD_OR:
+            if (a == BDD_TRUE || b == BDD_TRUE) {
+                return BDD_TRUE;
+            }
+            if (a == BDD_FALSE || a == b) {
+                return b;
+            }
+            if (b == BDD_FALSE) {
+                return a;
+            }
+            break;
+        default:
+            if (a == b) {
+                return BDD_FALSE;
+            }
+            if (a == BDD_FALSE) {
+                return b;
+            }
+            if (b == BDD_FALSE) {
+                return a;
+            }
+            break;
+    }
+
+    // All the operations are commutative
+    if (a > b) {
+        std::swap(a, b);
+    }
+    std::vector<Bdd_Cache_Entry> &cache = std::get<2>(bdd);
+    Bdd_Cache_Entry &entry = cache[bdd_hash(operation, a, b) & (cache.size() - 1)];
+    if (std::get<0>(entry) == operation && std::get<1>(entry) == a && std::get<2>(entry) == b) {
+        return std::get<3>(entry);
+    }
+
+    const uint32_t variable = std::min(bdd_variable(bdd, a), bdd_variable(bdd, b));
+    const uint32_t a_low = bdd_variable(bdd, a) == variable ? bdd_low(bdd, a) : a;
+    const uint32_t a_high = bdd_variable(bdd, a) == variable ? bdd_high(bdd, a) : a;
+    const uint32_t b_low = bdd_variable(bdd, b) == variable ? bdd_low(bdd, b) : b;
+    const uint32_t b_high = bdd_variable(bdd, b) == variable ? bdd_high(bdd, b) : b;
+
+    const uint32_t low = bdd_apply(bdd, operation, a_low, b_low);
+    if (low == BDD_OVERFLOW) {
+        return BDD_OVERFLOW;
+    }
+    const uint32_t high = bdd_apply(bdd, operation, a_high, b_high);
+    const uint32_t result = bdd_node(bdd, variable, low, high);
+    if (result == BDD_OVERFLOW) {
+        return BDD_OVERFLOW;
+    }
+
+    // The recursive calls may have reused the entry
+    cache[bdd_hash(operation, a, b) & (cache.size() - 1)] = { operation, a, b, result };
+    return result;
+}
+
+/**
+ * Orders the variables (start nodes) as they are first used by the gates
+ * in the topological order, so that the inputs of the same gates are
+ * close to each other. The unused start nodes go last.
+ */
+std::vector<uint32_t> get_variable_order(const Netlist &netlist) {
+    std::vector<uint32_t> order;
+    std::vector<uint8_t> ordered(get_start_nodes_count(netlist), 0);
+
+    for (uint32_t node = get_start_nodes_count(netlist); node < get_nodes_count(netlist); ++node) {
+        for (uint32_t e = get_fan_in_offsets(netlist)[node]; e < get_fan_in_offsets(netlist)[node + 1]; ++e) {
+            const uint32_t parent = get_fan_ins(netlist)[e];
+            if (parent < get_start_nodes_count(netlist) && not ordered[parent]) {
+                ordered[parent] = 1;
+                order.push_back(parent);
+            }
+        }
+    }
+    for (uint32_t node = 0; node < get_start_nodes_count(netlist); ++node) {
+        if (not ordered[node]) {
+            order.push_back(node);
+        }
+    }
+
+    return order;
+}
+
+/**
+ * Builds the reduced ordered diagrams of all nodes of the netlist. Returns
+ * them together with the diagram of every node, or an empty object if they
+ * would need more than @p BDD_NODES_LIMIT nodes.
+ */
+std::optional<std::pair<Bdd, std::vector<uint32_t>>> build_bdds(const Netlist &netlist) {
+    const std::vector<uint32_t> order = get_variable_order(netlist);
+    const uint32_t variables = order.size();
+
+    Bdd bdd;
+    get_bdd_nodes(bdd) = { { variables, BDD_FALSE, BDD_FALSE }, { variables, BDD_TRUE, BDD_TRUE } };
+    std::get<1>(bdd).assign(1024, 0);
+    // An entry with two equal arguments is never looked up
+    std::get<2>(bdd).assign(BDD_CACHE_SIZE, { BDD_AND, BDD_FALSE, BDD_FALSE, BDD_FALSE });
+    std::get<3>(bdd) = order;
+
+    std::vector<uint32_t> roots(get_nodes_count(netlist));
+    for (uint32_t variable = 0; variable < variables; ++variable) {
+        roots[order[variable]] = bdd_node(bdd, variable, BDD_FALSE, BDD_TRUE);
+        if (roots[order[variable]] == BDD_OVERFLOW) {
+            return { };
+        }
+    }
+
+    for (uint32_t node = get_start_nodes_count(netlist); node < get_nodes_count(netlist); ++node) {
+        const uint32_t first_edge = get_fan_in_offsets(netlist)[node];
+        const uint32_t last_edge = get_fan_in_offsets(netlist)[node + 1];
+        const gate_type type = get_gate_types(netlist)[node];
+        const bdd_operation operation = type == XOR || type == NOT ? BDD_XOR
+                                        : type == AND || type == NAND ? BDD_AND : BDD_OR;
+
+        uint32_t root = type == ONE ? BDD_TRUE : BDD_FALSE;
+        if (first_edge < last_edge) {
+            root = roots[get_fan_ins(netlist)[first_edge]];
+        }
+        for (uint32_t e = first_edge + 1; e < last_edge; ++e) {
+            root = bdd_apply(bdd, operation, root, roots[get_fan_ins(netlist)[e]]);
+        }
+        if (type == NOT || type == NAND || type == NOR) {
+            root = bdd_apply(bdd, BDD_XOR, root, BDD_TRUE);
+        }
+        if (root == BDD_OVERFLOW) {
+            return { };
+        }
+        roots[node] = root;
+    }
+
+    return { { std::move(bdd), std::move(roots) } };
+}
+
+/**
+ * Returns @p count multiplied by 2 to the power of @p shift, saturating
+ * at the largest 64-bit number.
+ */
+inline uint64_t shifted_count(uint64_t count, uint32_t shift) {
+    const uint64_t saturated = std::numeric_limits<uint64_t>::max();
+    if (count == 0) {
+        return 0;
+    }
+    return shift >= std::numeric_limits<uint64_t>::digits || count > (saturated >> shift)
+           ? saturated : count << shift;
+}
+
+/**
+ * Returns the number of rows of the truth table in which the diagram
+ * @p root is 1, saturating at the largest 64-bit number.
+ */
+uint64_t bdd_sat_count(const Bdd &bdd, uint32_t root) {
+    const uint64_t saturated = std::numeric_limits<uint64_t>::max();
+    // Number of assignments of the variables from the node's one on
+    std::unordered_map<uint32_t, uint64_t> counts = { { BDD_FALSE, 0 }, { BDD_TRUE, 1 } };
+    auto count_below = [&](uint32_t node, uint32_t successor) {
+        return shifted_count(counts[successor], bdd_variable(bdd, successor) - bdd_variable(bdd, node) - 1);
+    };
+
+    std::vector<uint32_t> stack = { root };
+    while (not stack.empty()) {
+        const uint32_t node = stack.back();
+        const bool low_counted = counts.find(bdd_low(bdd, node)) != counts.end();
+        const bool high_counted = counts.find(bdd_high(bdd, node)) != counts.end();
+
+        if (counts.find(node) != counts.end()) {
+            stack.pop_back();
+        }
+        else if (not low_counted || not high_counted) {
+            if (not low_counted) {
+                stack.push_back(bdd_low(bdd, node));
+            }
+            if (not high_counted) {
+                stack.push_back(bdd_high(bdd, node));
+            }
+        }
+        else {
+            const uint64_t low = count_below(node, bdd_low(bdd, node));
+            const uint64_t high = count_below(node, bdd_high(bdd, node));
+            counts[node] = low > saturated - high ? saturated : low + high;
+            stack.pop_back();
+        }
+    }
+
+    // The variables above the root do not matter
+    return shifted_count(counts[root], bdd_variable(bdd, root));
+}
+
+/**
+ * Returns the number of some row of the truth table in which the diagram
+ * @p root (other than @p BDD_FALSE) is 1.
+ */
+uint64_t bdd_any_row(const Bdd &bdd, uint32_t root) {
+    const uint32_t variables = get_variable_order(bdd).size();
+    uint64_t row = 0;
+    for (uint32_t node = root; node != BDD_TRUE; ) {
+        const bool high = bdd_low(bdd, node) == BDD_FALSE;
+        const uint32_t bit = variables - 1 - get_variable_order(bdd)[bdd_variable(bdd, node)];
+        if (high && bit < std::numeric_limits<uint64_t>::digits) {
+            row |= uint64_t{1} << bit;
+        }
+        node = high ? bdd_high(bdd, node) : bdd_low(bdd, node);
+    }
+    return row;
+}
+
+// Diagrams' nodes reachable from the netlist's nodes, with the start nodes
+// in place of the variables, each after its successors + the diagram of
+// every node of the netlist
+using Bdd_Program = std::pair<std::vector<Bdd_Node>, std::vector<uint32_t>>;
+
+/**
+ * Builds the diagrams of the netlist's nodes and keeps only their nodes
+ * needed to stream the rows. Returns an empty object if the diagrams are
+ * too large.
+ */
+std::optional<Bdd_Program> compile_bdds(const Netlist &netlist) {
+    auto diagrams = build_bdds(netlist);
+    if (not diagrams.has_value()) {
+        return { };
+    }
+    const auto &[bdd, roots] = diagrams.value();
+
+    // The successors of a node are created before it, so the nodes
+    // are kept in the order of their creation
+    std::vector<uint32_t> reachable(get_bdd_nodes(bdd).size(), 0);
+    for (auto root : roots) {
+        reachable[root] = 1;
+    }
+    for (uint32_t node = get_bdd_nodes(bdd).size() - 1; node > BDD_TRUE; --node) {
+        if (reachable[node]) {
+            reachable[bdd_low(bdd, node)] = reachable[bdd_high(bdd, node)] = 1;
+        }
+    }
+
+    std::vector<Bdd_Node> program = { get_bdd_nodes(bdd)[BDD_FALSE], get_bdd_nodes(bdd)[BDD_TRUE] };
+    std::vector<uint32_t> new_index(get_bdd_nodes(bdd).size());
+    new_index[BDD_FALSE] = BDD_FALSE;
+    new_index[BDD_TRUE] = BDD_TRUE;
+    for (uint32_t node = BDD_TRUE + 1; node < get_bdd_nodes(bdd).size(); ++node) {
+        if (reachable[node]) {
+            new_index[node] = program.size();
+            program.emplace_back(get_variable_order(bdd)[bdd_variable(bdd, node)],
+                                 new_index[bdd_low(bdd, node)], new_index[bdd_high(bdd, node)]);
+        }
+    }
+
+    std::vector<uint32_t> program_roots(roots.size());
+    for (uint32_t node = 0; node < roots.size(); ++node) {
+        program_roots[node] = new_index[roots[node]];
+    }
+
+    return { { std::move(program), std::move(program_roots) } };
+}
+
+/**
+ * Works like @p bit_parallel_simulation, but computes the lanes of all
+ * nodes of the diagrams instead of the gates, selecting between the lanes
+ * of the successors of every node by the lanes of its start node. It pays
+ * off for circuits whose shared diagrams have fewer nodes than gates.
+ */
+void bdd_simulation(const Netlist &netlist, const Bdd_Program &program, uint64_t first_row,
+                    uint64_t last_row, std::string &output)
+{
+    const auto &[nodes, roots] = program;
+    std::vector<Lanes> bdd_lanes(nodes.size() * LANE_WORDS, 0);
+    std::fill(bdd_lanes.begin() + BDD_TRUE * LANE_WORDS, bdd_lanes.begin() + (BDD_TRUE + 1) * LANE_WORDS,
+              ~Lanes{0});
+
+    lanes_simulation(netlist, first_row, last_row, output, [&](std::vector<Lanes> &lanes) {
+        for (uint32_t node = BDD_TRUE + 1; node < nodes.size(); ++node) {
+            const auto &[start_node, low, high] = nodes[node];
+            const Lanes *selector = &lanes[std::size_t{start_node} * LANE_WORDS];
+            const Lanes *low_lanes = &bdd_lanes[std::size_t{low} * LANE_WORDS];
+            const Lanes *high_lanes = &bdd_lanes[std::size_t{high} * LANE_WORDS];
+            Lanes *result = &bdd_lanes[std::size_t{node} * LANE_WORDS];
+            for (uint32_t w = 0; w < LANE_WORDS; ++w) {
+                result[w] = (selector[w] & high_lanes[w]) | (~selector[w] & low_lanes[w]);
+            }
+        }
+
+        for (uint32_t node = get_start_nodes_count(netlist); node < get_nodes_count(netlist); ++node) {
+            const Lanes *root_lanes = &bdd_lanes[std::size_t{roots[node]} * LANE_WORDS];
+            std::copy(root_lanes, root_lanes + LANE_WORDS, &lanes[std::size_t{node} * LANE_WORDS]);
+        }
+    });
+}
+
+/**
+ * Prints the number of rows in which the signal @p ID is 1, or tells
+ * whether the two signals @p compared are equivalent, giving a row
+ * in which they differ otherwise.
+ */
+void bdd_analysis(const Netlist &netlist, std::optional<uint32_t> ID,
+                  const std::vector<uint32_t> &compared, std::ostream &out)
+{
+    auto diagrams = build_bdds(netlist);
+    if (not diagrams.has_value()) {
+        display_error(BDD_LIMIT, 0, "", 0, BDD_NODES_LIMIT);
+        return;
+    }
+    auto &[bdd, roots] = diagrams.value();
+    const std::vector<uint32_t> &displayed_IDs = get_displayed_IDs(netlist);
+    auto root = [&](uint32_t signal) {
+        const std::size_t column = std::lower_bound(displayed_IDs.begin(), displayed_IDs.end(), signal)
+                                   - displayed_IDs.begin();
+        return roots[get_displaying_order(netlist)[column]];
+    };
+
+    if (ID.has_value()) {
+        out << "Signal " << ID.value() << " is 1 in " << bdd_sat_count(bdd, root(ID.value()))
+            << " of " << shifted_count(1, get_start_nodes_count(netlist)) << " rows.\n";
+    }
+    if (not compared.empty()) {
+        const uint32_t difference = bdd_apply(bdd, BDD_XOR, root(compared[0]), root(compared[1]));
+        if (difference == BDD_OVERFLOW) {
+            display_error(BDD_LIMIT, 0, "", 0, BDD_NODES_LIMIT);
+            return;
+        }
+        out << "Signals " << compared[0] << " and " << compared[1];
+        if (difference == BDD_FALSE) {
+            out << " are equivalent.\n";
+        }
+        else {
+            out << " differ in row " << bdd_any_row(bdd, difference) << ".\n";
+        }
+    }
+}
+
+
+/********************************
+ *
+ *     SEQUENTIAL SIMULATION
+ *
+ ********************************/
+
+
+// Default limit of sweeps over a feedback loop in one row
+constexpr uint32_t DEFAULT_MAX_STEPS = 100;
+
+/**
+ * Simulates a netlist with feedback loops. @p component_offsets delimit
+ * its strongly connected components, ordered so that every component
+ * depends only on the preceding ones, and @p node_IDs are the original
+ * indices of the nodes. The signals keep their values between consecutive
+ * rows, starting from zeros, so loops such as latches hold their state.
+ * Only the components whose inputs have changed are re-evaluated. A cyclic
+ * component is swept, in order, until none of its signals changes, but
+ * at most @p max_steps times; components which have not settled in some
+ * rows, including the rows after such a sweep in which they were not
+ * re-evaluated, are reported at the end. Prints the rows up to @p last_row to @p out.
+ */
+void sequential_simulation(const Netlist &netlist, const std::vector<uint32_t> &component_offsets,
+                           const std::vector<uint32_t> &node_IDs, uint32_t max_steps,
+                           uint64_t last_row, std::ostream &out)
+{
+    const uint32_t number_of_start_nodes = get_start_nodes_count(netlist);
+    const uint32_t components = component_offsets.size() - 1;
+    const auto [fan_out_offsets, fan_outs] = get_fan_outs(netlist);
+
+    std::vector<uint32_t> component_of(get_nodes_count(netlist), components);
+    std::vector<uint8_t> cyclic(components, 0);
+    for (uint32_t c = 0; c < components; ++c) {
+        for (uint32_t node = component_offsets[c]; node < component_offsets[c + 1]; ++node) {
+            component_of[node] = c;
+        }
+        // A single gate is a loop only if it is its own input
+        const uint32_t first = component_offsets[c];
+        cyclic[c] = component_offsets[c + 1] - first > 1
+            || std::find(get_fan_ins(netlist).begin() + get_fan_in_offsets(netlist)[first],
+                         get_fan_ins(netlist).begin() + get_fan_in_offsets(netlist)[first + 1],
+                         first) != get_fan_ins(netlist).begin() + get_fan_in_offsets(netlist)[first + 1];
+    }
+
+    Signals signals(get_nodes_count(netlist), 0);
+    // Components waiting for evaluation, the earliest first
+    std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> queue;
+    std::vector<uint8_t> queued(components, 0);
+    // Whether every component has not settled in its last evaluation
+    // + number of unsettled components + number of rows in which every
+    // component has been unsettled
+    std::vector<uint8_t> unsettled(components, 0);
+    uint32_t unsettled_count = 0;
+    std::vector<uint64_t> unsettled_rows(components, 0);
+    // Signals of the evaluated component before its evaluation
+    Signals previous;
+
+    auto schedule_fan_outs = [&](uint32_t node) {
+        for (uint32_t e = fan_out_offsets[node]; e < fan_out_offsets[node + 1]; ++e) {
+            const uint32_t component = component_of[fan_outs[e]];
+            if (component != component_of[node] && not queued[component]) {
+                queued[component] = 1;
+                queue.push(component);
+            }
+        }
+    };
+
+    for (uint32_t c = 0; c < components; ++c) {
+        queued[c] = 1;
+        queue.push(c);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t print_ns = 0;
+    std::string output;
+    auto write_output = [&]() {
+        const auto print_start = std::chrono::steady_clock::now();
+        out.write(output.data(), output.size());
+        print_ns += elapsed_ns(print_start);
+        add_statistic(BYTES_WRITTEN, output.size());
+        output.clear();
+    };
+
+    for (uint64_t row = 0; ; ++row) {
+        for (uint32_t node = 0; node < number_of_start_nodes; ++node) {
+            if (signals[node] != start_signal(netlist, node, row)) {
+                signals[node] = not signals[node];
+                schedule_fan_outs(node);
+            }
+        }
+
+        while (not queue.empty()) {
+            const uint32_t component = queue.top();
+            queue.pop();
+            queued[component] = 0;
+
+            const uint32_t first = component_offsets[component];
+            const uint32_t last = component_offsets[component + 1];
+            previous.assign(signals.begin() + first, signals.begin() + last);
+
+            bool changed = true;
+            for (uint32_t step = 0; changed && step < (cyclic[component] ? max_steps : 1); ++step) {
+                changed = false;
+                for (uint32_t node = first; node < last; ++node) {
+                    const bool signal = compute_signal_val(netlist, signals, node);
+                    changed = changed || signal != signals[node];
+                    signals[node] = signal;
+                }
+            }
+            // A component which is not re-evaluated stays unsettled
+            if (unsettled[component] != (changed && cyclic[component])) {
+                unsettled[component] = changed && cyclic[component];
+                if (unsettled[component]) {
+                    ++unsettled_count;
+                }
+                else {
+                    --unsettled_count;
+                }
+            }
+
+            for (uint32_t node = first; node < last; ++node) {
+                if (signals[node] != previous[node - first]) {
+                    schedule_fan_outs(node);
+                }
+            }
+        }
+
+        for (uint32_t c = 0; unsettled_count > 0 && c < components; ++c) {
+            unsettled_rows[c] += unsettled[c];
+        }
+
+        print_signals(netlist, signals, output);
+        if (output.size() >= CHUNK_BYTES) {
+            write_output();
+        }
+
+        if (row == last_row) {
+            break;
+        }
+    }
+    write_output();
+    add_statistic(SIMULATE_NS, elapsed_ns(start) - print_ns);
+    add_statistic(PRINT_NS, print_ns);
+
+    for (uint32_t c = 0; c < components; ++c) {
+        if (unsettled_rows[c] > 0) {
+            std::vector<uint32_t> IDs(node_IDs.begin() + component_offsets[c],
+                                      node_IDs.begin() + component_offsets[c + 1]);
+            std::sort(IDs.begin(), IDs.end());
+            std::string signal_list;
+            for (auto ID : IDs) {
+                signal_list += (signal_list.empty() ? "" : " ") + std::to_string(ID);
+            }
+            display_error(OSCILLATION, 0, signal_list, 0, unsettled_rows[c]);
+        }
+    }
+}
+
+
+/********************************
+ *
+ *       OBSERVED SIGNALS
+ *
+ ********************************/
+
+
+// Values of the cone's inputs with '-' for the inputs which do not matter,
+// starting from the last input + number of the observed signals' values
+using Cube = std::pair<std::string, uint32_t>;
+// Cubes covering an aligned block of rows + binary logarithm of the number
+// of rows + number of the first row
+using Block = std::tuple<std::vector<Cube>, uint32_t, uint64_t>;
+
+/**
+ * Parses a comma-separated list of indices of signals. Returns an empty
+ * object if the list is malformed.
+ */
+std::optional<std::vector<uint32_t>> get_signal_list(std::string_view list) {
+    std::vector<uint32_t> signals;
+
+    for (std::size_t separator = 0; separator != std::string_view::npos; ) {
+        separator = list.find(',');
+        const std::optional<uint32_t> ID = get_number(list.substr(0, separator));
+        if (not ID.has_value()) {
+            return { };
+        }
+        signals.push_back(ID.value());
+        list.remove_prefix(separator == std::string_view::npos ? list.size() : separator + 1);
+    }
+
+    return { signals };
+}
+
+/**
+ * Removes from the graph all nodes outside the transitive fan-in cones
+ * of the @p observed signals, so that no gate nobody asked to see is
+ * simulated and the inputs the observed signals do not depend on are
+ * not enumerated.
+ */
+void restrict_to_cones(Graph &graph, const std::vector<uint32_t> &observed) {
+    std::vector<uint8_t> in_cone(get_graph_size(graph), 0);
+    std::vector<uint32_t> stack;
+    for (auto ID : observed) {
+        const uint32_t node = find_node(graph, ID);
+        if (not in_cone[node]) {
+            in_cone[node] = 1;
+            stack.push_back(node);
+        }
+    }
+
+    while (not stack.empty()) {
+        const uint32_t node = stack.back();
+        stack.pop_back();
+        for (auto neighbour : get_incoming_edges(graph, node)) {
+            if (not in_cone[neighbour]) {
+                in_cone[neighbour] = 1;
+                stack.push_back(neighbour);
+            }
+        }
+    }
+
+    // The nodes in the cones keep their order
+    std::vector<uint32_t> new_position(get_graph_size(graph), NO_NODE);
+    uint32_t cone_size = 0;
+    for (uint32_t node = 0; node < get_graph_size(graph); ++node) {
+        if (in_cone[node]) {
+            new_position[node] = cone_size++;
+        }
+    }
+
+    Graph cone;
+    reserve_nodes(cone, cone_size);
+    for (uint32_t node = 0; node < get_graph_size(graph); ++node) {
+        if (in_cone[node]) {
+            const std::span<const uint32_t> incoming_edges = get_incoming_edges(graph, node);
+            const uint32_t first_edge = std::get<2>(cone).size();
+            for (auto neighbour : incoming_edges) {
+                std::get<2>(cone).push_back(new_position[neighbour]);
+            }
+            insert_node(cone, get_node_IDs(graph)[node],
+                        { get_gate_type(graph, node), first_edge, incoming_edges.size() });
+        }
+    }
+    add_statistic(HASH_LOOKUPS, observed.size() + cone_size);
+
+    graph = std::move(cone);
+}
+
+/**
+ * Merges the two topmost blocks on the @p stack while they are of equal
+ * size. Two halves with the same cubes do not depend on the input which
+ * tells them apart, otherwise the input is fixed in the cubes of both.
+ */
+void merge_blocks(std::vector<Block> &stack) {
+    while (stack.size() >= 2 && std::get<1>(stack.back()) == std::get<1>(stack[stack.size() - 2])) {
+        Block right = std::move(stack.back());
+        stack.pop_back();
+        auto &[cubes, size, first_row] = stack.back();
+        const bool same = cubes == std::get<0>(right);
+
+        for (auto &cube : cubes) {
+            cube.first += same ? '-' : '0';
+        }
+        if (not same) {
+            for (auto &cube : std::get<0>(right)) {
+                cube.first += '1';
+                cubes.push_back(std::move(cube));
+            }
+        }
+        ++size;
+    }
+}
+
+/**
+ * Prints the truth table of the @p observed signals computed by @p engine
+ * for the rows up to @p last_row, merging the rows with the same observed
+ * values into cubes. Every line consists of the values of all @p inputs
+ * of the circuit, with '-' for the ones the values do not depend on,
+ * followed by the values of the observed signals.
+ */
+void observed_simulation(const Netlist &netlist, const Engine &engine, const std::vector<uint32_t> &inputs,
+                         const std::vector<uint32_t> &observed, uint64_t last_row, std::ostream &out)
+{
+    const std::vector<uint32_t> &displayed_IDs = get_displayed_IDs(netlist);
+    const uint32_t number_of_start_nodes = get_start_nodes_count(netlist);
+    const std::size_t row_bytes = displayed_IDs.size() + 1;
+    auto column = [&displayed_IDs](uint32_t ID) -> std::size_t {
+        return std::lower_bound(displayed_IDs.begin(), displayed_IDs.end(), ID) - displayed_IDs.begin();
+    };
+
+    // Distinct values of the observed signals + their numbers
+    std::vector<std::string> values;
+    std::unordered_map<std::string, uint32_t> value_numbers;
+    std::vector<Block> stack;
+    std::string row_values(observed.size(), '0');
+    std::string output;
+
+    const uint64_t chunk_rows = rows_per_chunk(netlist);
+    for (uint64_t first_row = 0; ; first_row += chunk_rows) {
+        const uint64_t rows = std::min(last_row - first_row, chunk_rows - 1) + 1;
+        output.clear();
+        engine(first_row, first_row + rows - 1, output);
+
+        for (uint64_t r = 0; r < rows; ++r) {
+            for (std::size_t i = 0; i < observed.size(); ++i) {
+                row_values[i] = output[r * row_bytes + column(observed[i])];
+            }
+            const auto value = value_numbers.try_emplace(row_values, values.size()).first;
+            if (value->second == values.size()) {
+                values.push_back(row_values);
+            }
+            stack.emplace_back(std::vector<Cube>{ { "", value->second } }, 0, first_row + r);
+            merge_blocks(stack);
+        }
+
+        if (last_row - first_row < chunk_rows) {
+            break;
+        }
+    }
+
+    std::vector<char> cone_inputs(number_of_start_nodes);
+    output.clear();
+    for (auto &[cubes, size, first_row] : stack) {
+        for (auto &[cube, value] : cubes) {
+            // The inputs above the block are fixed by its position
+            for (uint32_t i = 0; i < number_of_start_nodes; ++i) {
+                cone_inputs[i] = i + size < number_of_start_nodes ? (start_signal(netlist, i, first_row) ? '1' : '0')
+                                                                 : cube[number_of_start_nodes - 1 - i];
+            }
+            for (auto ID : inputs) {
+                const std::size_t input = column(ID);
+                output += input < displayed_IDs.size() && displayed_IDs[input] == ID
+                          ? cone_inputs[get_displaying_order(netlist)[input]] : '-';
+            }
+            output += ' ';
+            output += values[value];
+            output += '\n';
+        }
+        if (output.size() >= CHUNK_BYTES) {
+            out.write(output.data(), output.size());
+            output.clear();
+        }
+    }
+    out.write(output.data(), output.size());
+}
+
+
+/********************************
+ *
+ *   BENCHMARK AND GENERATOR
+ *
+ ********************************/
+
+
+// Names of the gate types in the input format
+const std::unordered_map<gate_type, std::string> GATE_NAMES = {
+    { NOT, "NOT" },
+    { XOR, "XOR" },
+    { AND, "AND" },
+    { NAND, "NAND" },
+    { OR, "OR" },
+    { NOR, "NOR" },
+    // Produced only by the optimisation
+    { ZERO, "ZERO" },
+    { ONE, "ONE" }
+};
+
+// Function printing a circuit generated for the given numbers of inputs
+// and gates, maximal fan-in and depth (0 if not limited). The indices
+// of the inputs are 1, 2, ..., the gates get the next ones.
+using Generator = void (*)(uint32_t, uint32_t, uint32_t, uint32_t, std::mt19937_64 &, std::ostream &);
+
+/**
+ * Prints a gate in the input format and returns its index,
+ * the next one after the last used @p last_ID.
+ */
+inline uint32_t print_gate(std::ostream &out, uint32_t &last_ID, gate_type type,
+                           const std::vector<uint32_t> &inputs)
+{
+    out << GATE_NAMES.find(type)->second << ' ' << ++last_ID;
+    for (auto input : inputs) {
+        out << ' ' << input;
+    }
+    out << '\n';
+    return last_ID;
+}
+
+/**
+ * Random acyclic circuit. With a limited depth the gates are spread evenly
+ * over the levels and every gate has an input on the preceding level.
+ */
+void generate_random(uint32_t inputs, uint32_t gates, uint32_t fan_in, uint32_t depth,
+                     std::mt19937_64 &random, std::ostream &out)
+{
+    const gate_type types[] = { NOT, XOR, AND, NAND, OR, NOR };
+    uint32_t last_ID = inputs;
+    // Index of the first node on the preceding and on the current level
+    uint32_t previous_level = 1;
+    uint32_t current_level = 1;
+    uint32_t level = 0;
+
+    for (uint32_t g = 0; g < gates; ++g) {
+        if (depth > 0 && (level == 0 || static_cast<uint64_t>(g) * depth / gates >= level)) {
+            previous_level = current_level;
+            current_level = last_ID + 1;
+            ++level;
+        }
+        const uint32_t first_candidate = depth > 0 ? previous_level : 1;
+        const uint32_t candidates = depth > 0 ? current_level : last_ID + 1;
+
+        const gate_type type = types[random() % std::size(types)];
+        const uint32_t count = type == NOT ? 1 : type == XOR ? 2 : 2 + random() % std::max(fan_in - 1, 1u);
+        std::vector<uint32_t> gate_inputs;
+        gate_inputs.push_back(first_candidate + random() % (candidates - first_candidate));
+        while (gate_inputs.size() < count) {
+            gate_inputs.push_back(1 + random() % (candidates - 1));
+        }
+        print_gate(out, last_ID, type, gate_inputs);
+    }
+}
+
+/**
+ * Prints a full adder of the given bits and returns its sum and carry.
+ */
+std::pair<uint32_t, uint32_t> print_full_adder(std::ostream &out, uint32_t &last_ID,
+                                               uint32_t a, uint32_t b, uint32_t carry)
+{
+    const uint32_t half_sum = print_gate(out, last_ID, XOR, { a, b });
+    const uint32_t half_carry = print_gate(out, last_ID, AND, { a, b });
+    const uint32_t sum = print_gate(out, last_ID, XOR, { half_sum, carry });
+    const uint32_t carried = print_gate(out, last_ID, AND, { half_sum, carry });
+    return { sum, print_gate(out, last_ID, OR, { half_carry, carried }) };
+}
+
+/**
+ * Prints a ripple-carry adder of two numbers given as bits, the least
+ * significant first, and returns the bits of the sum. The number @p a
+ * may have fewer bits than @p b.
+ */
+std::vector<uint32_t> print_adder(std::ostream &out, uint32_t &last_ID,
+                                  const std::vector<uint32_t> &a, const std::vector<uint32_t> &b)
+{
+    std::vector<uint32_t> sum;
+    // Index 0 stands for no carry
+    uint32_t carry = 0;
+    for (std::size_t i = 0; i < b.size(); ++i) {
+        if (i < a.size() && carry != 0) {
+            const auto [bit, next_carry] = print_full_adder(out, last_ID, a[i], b[i], carry);
+            sum.push_back(bit);
+            carry = next_carry;
+        }
+        else if (i < a.size() || carry != 0) {
+            const uint32_t other = i < a.size() ? a[i] : carry;
+            sum.push_back(print_gate(out, last_ID, XOR, { other, b[i] }));
+            carry = print_gate(out, last_ID, AND, { other, b[i] });
+        }
+        else {
+            sum.push_back(b[i]);
+        }
+    }
+    if (carry != 0) {
+        sum.push_back(carry);
+    }
+    return sum;
+}
+
+/**
+ * Ripple-carry adder of two numbers with half of the inputs each.
+ */
+void generate_adder(uint32_t inputs, uint32_t, uint32_t, uint32_t, std::mt19937_64 &, std::ostream &out) {
+    const uint32_t bits = std::max(inputs / 2, 1u);
+    std::vector<uint32_t> a, b;
+    for (uint32_t i = 1; i <= bits; ++i) {
+        a.push_back(i);
+        b.push_back(bits + i);
+    }
+    uint32_t last_ID = 2 * bits;
+    print_adder(out, last_ID, a, b);
+}
+
+/**
+ * Array multiplier of two numbers with half of the inputs each: rows
+ * of partial products are accumulated by ripple-carry adders.
+ */
+void generate_multiplier(uint32_t inputs, uint32_t, uint32_t, uint32_t, std::mt19937_64 &, std::ostream &out) {
+    const uint32_t bits = std::max(inputs / 2, 1u);
+    uint32_t last_ID = 2 * bits;
+    std::vector<uint32_t> product;
+
+    for (uint32_t j = 0; j < bits; ++j) {
+        std::vector<uint32_t> partial;
+        for (uint32_t i = 1; i <= bits; ++i) {
+            partial.push_back(print_gate(out, last_ID, AND, { i, bits + 1 + j }));
+        }
+
+        if (j == 0) {
+            product = std::move(partial);
+        }
+        else {
+            // The lowest j bits of the product are final already
+            const std::vector<uint32_t> upper(product.begin() + j, product.end());
+            const std::vector<uint32_t> sum = print_adder(out, last_ID, upper, partial);
+            product.resize(j);
+            product.insert(product.end(), sum.begin(), sum.end());
+        }
+    }
+}
+
+/**
+ * Tree reducing all inputs to one signal, with levels of gates with
+ * the given fan-in, alternately AND and OR.
+ */
+void generate_tree(uint32_t inputs, uint32_t, uint32_t fan_in, uint32_t, std::mt19937_64 &, std::ostream &out) {
+    std::vector<uint32_t> level;
+    for (uint32_t i = 1; i <= std::max(inputs, 2u); ++i) {
+        level.push_back(i);
+    }
+    uint32_t last_ID = level.size();
+    const std::size_t width = std::max(fan_in, 2u);
+
+    for (bool conjunction = true; level.size() > 1; conjunction = not conjunction) {
+        std::vector<uint32_t> next_level;
+        for (std::size_t i = 0; i < level.size(); i += width) {
+            const std::vector<uint32_t> group(level.begin() + i, level.begin() + std::min(i + width, level.size()));
+            next_level.push_back(group.size() == 1 ? group[0]
+                                 : print_gate(out, last_ID, conjunction ? AND : OR, group));
+        }
+        level = std::move(next_level);
+    }
+}
+
+/**
+ * Chains of NOT gates starting at every input; the depth (or else the
+ * number of gates divided by the number of inputs) is the chains' length.
+ */
+void generate_chain(uint32_t inputs, uint32_t gates, uint32_t, uint32_t depth, std::mt19937_64 &, std::ostream &out) {
+    const uint32_t length = depth > 0 ? depth : std::max(gates / inputs, 1u);
+    uint32_t last_ID = inputs;
+    for (uint32_t i = 1; i <= inputs; ++i) {
+        uint32_t previous = i;
+        for (uint32_t g = 0; g < length; ++g) {
+            previous = print_gate(out, last_ID, NOT, { previous });
+        }
+    }
+}
+
+// Accepted values of the "generate" option
+const std::unordered_map<std::string, Generator> GENERATORS = {
+    { "random", generate_random },
+    { "adder", generate_adder },
+    { "multiplier", generate_multiplier },
+    { "tree", generate_tree },
+    { "chain", generate_chain }
+};
+
+/**
+ * Returns @p count per second of @p time without overflowing; the precision
+ * of the time is lowered for long times.
+ */
+inline uint64_t per_second(uint64_t count, std::chrono::nanoseconds time) {
+    uint64_t ticks = time.count();
+    uint64_t ticks_per_second = 1000000000;
+    while (ticks_per_second > 1 && ticks > std::numeric_limits<uint64_t>::max() / ticks_per_second) {
+        ticks /= 1000;
+        ticks_per_second /= 1000;
+    }
+    ticks = std::max<uint64_t>(ticks, 1);
+    return count / ticks * ticks_per_second + count % ticks * ticks_per_second / ticks;
+}
+
+/**
+ * Prints the result of the "benchmark" option as a JSON object: the size
+ * of the netlist simulated by the engine @p engine_name with @p threads
+ * threads, the times of the phases and the rates of the simulation.
+ */
+void print_benchmark(const std::string &engine_name, uint32_t threads, const Netlist &netlist, uint64_t rows,
+                     std::chrono::nanoseconds parse_time, std::chrono::nanoseconds topo_sort_time,
+                     std::chrono::nanoseconds simulation_time, std::ostream &out)
+{
+    const uint64_t gates = get_nodes_count(netlist) - get_start_nodes_count(netlist);
+    out << "{\"engine\": \"" << engine_name << "\", "
+        << "\"threads\": " << threads << ", "
+        << "\"nodes\": " << get_nodes_count(netlist) << ", "
+        << "\"start_nodes\": " << get_start_nodes_count(netlist) << ", "
+        << "\"gates\": " << gates << ", "
+        << "\"rows\": " << rows << ", "
+        << "\"parse_ns\": " << parse_time.count() << ", "
+        << "\"topo_sort_ns\": " << topo_sort_time.count() << ", "
+        << "\"simulation_ns\": " << simulation_time.count() << ", "
+        << "\"rows_per_second\": " << per_second(rows, simulation_time) << ", "
+        << "\"gates_per_second\": " << per_second(rows * gates, simulation_time) << "}\n";
+}
+
+/**
+ * Prints the statistics of the run as a JSON object, together with the
+ * number of gates of every type in the netlist. The nominal evaluations of
+ * a gate type are its count times @p rows, the work of a plain row by row
+ * simulation, not a measurement: the incremental engine skips gates whose
+ * inputs did not change, the bytecode fuses some of them and --sat-count
+ * builds a BDD instead of simulating rows.
+ */
+void print_statistics(const Netlist &netlist, uint64_t rows, std::ostream &out) {
+    std::map<std::string, uint64_t> gates;
+    for (uint32_t node = get_start_nodes_count(netlist); node < get_nodes_count(netlist); ++node) {
+        ++gates[GATE_NAMES.find(get_gate_types(netlist)[node])->second];
+    }
+
+    out << "{";
+    for (uint32_t kind = 0; kind < STATISTICS_COUNT; ++kind) {
+        out << "\"" << STATISTIC_NAMES[kind] << "\": " << statistics[kind].load() << ", ";
+    }
+    out << "\"rows\": " << rows << ", \"gates\": {";
+    for (auto gate = gates.begin(); gate != gates.end(); ++gate) {
+        out << (gate == gates.begin() ? "" : ", ") << "\"" << gate->first << "\": {\"count\": "
+            << gate->second << ", \"nominal_evaluations\": " << gate->second * rows << "}";
+    }
+    out << "}}\n";
+}
+
+
+/********************************
+ *
+ *     COMMAND LINE OPTIONS
+ *
+ ********************************/
+
+
+// Option's name + its value (empty for options given without a value)
+using Options = std::unordered_map<std::string, std::string>;
+
+// Kinds of options
+enum option_kind {
+    FLAG,
+    NUMBER,
+    // Number of a row of the truth table, which may be 0 or exceed
+    // the limit of indices of nodes
+    ROW,
+    TEXT
+};
+
+// Names of the accepted options + their kinds
+const std::unordered_map<std::string, option_kind> OPTION_NAMES = {
+    { "engine", TEXT },
+    { "threads", NUMBER },
+    { "input", TEXT },
+    { "optimise", FLAG },
+    { "rows", NUMBER },
+    { "benchmark", FLAG },
+    { "generate", TEXT },
+    { "inputs", NUMBER },
+    { "gates", NUMBER },
+    { "fan-in", NUMBER },
+    { "depth", NUMBER },
+    { "seed", NUMBER },
+    { "sequential", FLAG },
+    { "max-steps", NUMBER },
+    { "observe", TEXT },
+    { "sat-count", NUMBER },
+    { "equivalent", TEXT },
+    // Directory of compiled netlists, used only with "input" and not
+    // with "observe" or "sequential"
+    { "cache", TEXT },
+    { "stats", FLAG },
+    // Range of rows of the truth table (inclusive) + file saving the progress
+    // of the run, which resumes from it; not used with "observe" or "sequential"
+    { "from", ROW },
+    { "to", ROW },
+    { "checkpoint", TEXT },
+    // Counting the ones and the changes of the signals instead of printing
+    // the rows, not used with "observe", "sequential" or "checkpoint"
+    { "activity", FLAG }
+};
+
+// Accepted values of the "engine" option
+const std::unordered_map<std::string, Engine_Factory> ENGINES = {
+    { "scalar", [](const Netlist &netlist, uint32_t) -> Engine {
+        return [&netlist](uint64_t first_row, uint64_t last_row, std::string &output) {
+            scalar_simulation(netlist, first_row, last_row, output);
+        };
+    } },
+    { "bit-parallel", [](const Netlist &netlist, uint32_t) -> Engine {
+        return [&netlist](uint64_t first_row, uint64_t last_row, std::string &output) {
+            bit_parallel_simulation(netlist, first_row, last_row, output);
+        };
+    } },
+    { "incremental", [](const Netlist &netlist, uint32_t) -> Engine {
+        return [&netlist, fan_outs = get_fan_outs(netlist), columns = get_columns(netlist)](
+            uint64_t first_row, uint64_t last_row, std::string &output)
+        {
+            incremental_simulation(netlist, fan_outs, columns, first_row, last_row, output);
+        };
+    } },
+    { "bytecode", [](const Netlist &netlist, uint32_t) -> Engine {
+        return [&netlist, program = compile_bytecode(netlist)](
+            uint64_t first_row, uint64_t last_row, std::string &output)
+        {
+            bytecode_simulation(netlist, program, first_row, last_row, output);
+        };
+    } },
+    // Uses the threads within a row rather than for separate chunks
+    { "wavefront", [](const Netlist &netlist, uint32_t threads) -> Engine {
+        return [&netlist, pool = start_wavefront_pool(netlist, threads)](
+            uint64_t first_row, uint64_t last_row, std::string &output)
+        {
+            wavefront_simulation(netlist, *pool, first_row, last_row, output);
+        };
+    } },
+    // Formats the batches of rows prepared for a row consumer
+    { "packed", [](const Netlist &netlist, uint32_t) -> Engine {
+        return [&netlist, program = compile_bytecode(netlist)](
+            uint64_t first_row, uint64_t last_row, std::string &output)
+        {
+            Row_Batch batch;
+            pack_rows(netlist, program, first_row, last_row, batch);
+            format_batch(netlist, batch, output);
+        };
+    } },
+    // Falls back to the bytecode if the diagrams are too large
+    { "bdd", [](const Netlist &netlist, uint32_t threads) -> Engine {
+        std::optional<Bdd_Program> program = compile_bdds(netlist);
+        if (not program.has_value()) {
+            display_error(BDD_LIMIT, 0, "", 0, BDD_NODES_LIMIT);
+            return ENGINES.find("bytecode")->second(netlist, threads);
+        }
+        return [&netlist, program = std::move(program.value())](
+            uint64_t first_row, uint64_t last_row, std::string &output)
+        {
+            bdd_simulation(netlist, program, first_row, last_row, output);
+        };
+    } }
+};
+
+/**
+ * Parses arguments of the form @p --name or @p --name=value. Reports
+ * the first unknown, repeated or malformed option and returns an empty
+ * object then.
+ */
+std::optional<Options> get_options(int argc, char *argv[]) {
+    Options options;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument(argv[i]);
+        const std::size_t separator = argument.find('=');
+        const std::string name = argument.substr(0, separator);
+        const std::string value = separator == std::string::npos ? "" : argument.substr(separator + 1);
+
+        const auto option = name.size() > 2 && name.compare(0, 2, "--") == 0
+                            ? OPTION_NAMES.find(name.substr(2)) : OPTION_NAMES.end();
+
+        if (option == OPTION_NAMES.end() || (option->second == FLAG) != (separator == std::string::npos)
+            || (option->second == NUMBER && not get_number(value).has_value())
+            || (option->second == ROW && not get_row_number(value).has_value())
+            || options.find(name.substr(2)) != options.end()) {
+            display_error(INVALID_OPTION, 0, argument);
+            return {};
+        }
+        options[name.substr(2)] = value;
+    }
+
+    if (options.find("engine") != options.end() && ENGINES.find(options["engine"]) == ENGINES.end()) {
+        display_error(INVALID_OPTION, 0, "--engine=" + options["engine"]);
+        return {};
+    }
+    if (options.find("generate") != options.end() && GENERATORS.find(options["generate"]) == GENERATORS.end()) {
+        display_error(INVALID_OPTION, 0, "--generate=" + options["generate"]);
+        return {};
+    }
+    if (options.find("cache") != options.end() && options.find("input") == options.end()) {
+        display_error(INVALID_OPTION, 0, "--cache=" + options["cache"]);
+        return {};
+    }
+    for (const std::string name : { "from", "to", "checkpoint" }) {
+        if (options.find(name) != options.end()
+            && (options.find("observe") != options.end() || options.find("sequential") != options.end())) {
+            display_error(INVALID_OPTION, 0, "--" + name + "=" + options[name]);
+            return {};
+        }
+    }
+    if (options.find("activity") != options.end()
+        && (options.find("observe") != options.end() || options.find("sequential") != options.end()
+            || options.find("checkpoint") != options.end())) {
+        display_error(INVALID_OPTION, 0, "--activity");
+        return {};
+    }
+
+    return { options };
+}
+
+
+/********************************
+ *
+ *            MAIN
+ *
+ ********************************/
+
+
+int main(int argc, char *argv[]) {
+    // The rows are written in large blocks, there is no need for C stdio's buffering
+    std::ios_base::sync_with_stdio(false);
+
+    std::optional<Options> options = get_options(argc, argv);
+    if (not options.has_value()) {
+        return 1;
+    }
+
+    auto option = [&options](const std::string &name) {
+        return options.value().find(name) != options.value().end();
+    };
+    auto numeric_option = [&options](const std::string &name, uint32_t default_value) {
+        return get_number(options.value()[name]).value_or(default_value);
+    };
+    auto row_option = [&options](const std::string &name) {
+        return get_row_number(options.value()[name]).value_or(0);
+    };
+    const uint32_t threads = numeric_option("threads", 1);
+
+    // Printing a generated circuit instead of simulating one
+    if (option("generate")) {
+        std::mt19937_64 random(numeric_option("seed", 1));
+        GENERATORS.find(options.value()["generate"])->second(
+            numeric_option("inputs", 16), numeric_option("gates", 1000),
+            numeric_option("fan-in", 2), numeric_option("depth", 0), random, std::cout
+        );
+        return 0;
+    }
+
+    // Parsing the input and building a graph, unless the netlist compiled
+    // from the same input is cached
+    const auto parse_start = std::chrono::steady_clock::now();
+    std::optional<Graph> graph;
+    std::optional<Netlist> cached_netlist;
+    std::string cache_file;
+    std::optional<std::string_view> text;
+    uint64_t hash = 0;
+    if (option("cache") && not option("observe") && not option("sequential")) {
+        text = map_file(options.value()["input"]);
+        if (not text.has_value()) {
+            display_error(INPUT_ERROR, 0, options.value()["input"]);
+            return 0;
+        }
+        hash = text_hash(text.value());
+        cache_file = cache_path(options.value()["cache"], hash);
+        cached_netlist = load_netlist(cache_file, text.value(), hash);
+        if (not cached_netlist.has_value()) {
+            graph = get_graph(text.value(), threads);
+        }
+    }
+    else {
+        graph = option("input") ? get_graph(options.value()["input"], threads) : get_graph();
+    }
+    if (not graph.has_value() && not cached_netlist.has_value()) {
+        return 0;
+    }
+    add_statistic(PARSE_NS, elapsed_ns(parse_start) - statistics[START_NODES_NS].load());
+
+    // Leaving only the nodes the observed signals depend on
+    std::vector<uint32_t> inputs;
+    std::vector<uint32_t> observed;
+    if (option("observe")) {
+        for (uint32_t node = 0; node < get_graph_size(graph.value()); ++node) {
+            if (get_gate_type(graph.value(), node) == START) {
+                inputs.push_back(get_node_IDs(graph.value())[node]);
+            }
+        }
+        std::sort(inputs.begin(), inputs.end());
+
+        const auto observed_IDs = get_signal_list(options.value()["observe"]);
+        if (not observed_IDs.has_value()
+            || std::any_of(observed_IDs.value().begin(), observed_IDs.value().end(), [&graph](uint32_t ID) {
+                   return find_node(graph.value(), ID) == NO_NODE;
+               })) {
+            display_error(INVALID_OPTION, 0, "--observe=" + options.value()["observe"]);
+            return 1;
+        }
+        observed = observed_IDs.value();
+        restrict_to_cones(graph.value(), observed);
+    }
 
     // Ordering the nodes
-    auto node_order = topo_sort(graph.value());
-    
-    if (not node_order.has_value()) {
+    const auto topo_sort_start = std::chrono::steady_clock::now();
+    std::optional<std::vector<uint32_t>> node_order;
+    if (graph.has_value()) {
+        node_order = topo_sort(graph.value());
+    }
+    const auto topo_sort_end = std::chrono::steady_clock::now();
+    add_statistic(TOPO_SORT_NS, (topo_sort_end - topo_sort_start).count());
+
+    if (graph.has_value() && not node_order.has_value() && option("sequential")) {
+        const auto compile_start = std::chrono::steady_clock::now();
+        const auto [component_order, component_offsets] = component_sort(graph.value());
+        const Netlist netlist = compile_netlist(graph.value(), component_order);
+        std::vector<uint32_t> component_IDs(component_order.size());
+        for (uint32_t i = 0; i < component_order.size(); ++i) {
+            component_IDs[i] = get_node_IDs(graph.value())[component_order[i]];
+        }
+        graph.reset();
+        add_statistic(COMPILE_NS, elapsed_ns(compile_start));
+
+        const uint64_t last_row = option("rows")
+                                  ? std::min<uint64_t>(last_row_number(netlist), numeric_option("rows", 1) - 1)
+                                  : last_row_number(netlist);
+        std::ostream discarded(nullptr);
+        const auto simulation_start = std::chrono::steady_clock::now();
+        sequential_simulation(netlist, component_offsets, component_IDs,
+                              numeric_option("max-steps", DEFAULT_MAX_STEPS), last_row,
+                              option("benchmark") ? discarded : std::cout);
+        const auto simulation_end = std::chrono::steady_clock::now();
+
+        if (option("benchmark")) {
+            print_benchmark("sequential", 1, netlist, last_row + 1, topo_sort_start - parse_start,
+                            topo_sort_end - topo_sort_start, simulation_end - simulation_start, std::cout);
+        }
+        if (option("stats")) {
+            print_statistics(netlist, last_row + 1, std::cerr);
+        }
+    }
+    else if (graph.has_value() && not node_order.has_value()) {
         display_error(CYCLE);
     }
     else {
-        // The order in which the nodes should be displayed
-        std::vector<uint32_t> displaying_order(graph.value().size());
-        uint32_t ID = 0;
-        for (const auto &node : graph.value()) {
-            displaying_order[ID] = node.first;
-            ++ID;
+        const auto compile_start = std::chrono::steady_clock::now();
+        Netlist netlist = cached_netlist.has_value() ? std::move(cached_netlist.value())
+                                                     : compile_netlist(graph.value(), node_order.value());
+        graph.reset();
+        add_statistic(COMPILE_NS, elapsed_ns(compile_start));
+        if (text.has_value()) {
+            if (not cached_netlist.has_value()) {
+                save_netlist(cache_file, netlist, text.value(), hash);
+            }
+            unmap_file(text.value());
+        }
+
+        // Signals analysed symbolically instead of printing the truth table
+        std::optional<uint32_t> counted;
+        std::vector<uint32_t> compared;
+        if (option("sat-count")) {
+            counted = numeric_option("sat-count", 1);
+            if (not is_displayed(netlist, counted.value())) {
+                display_error(INVALID_OPTION, 0, "--sat-count=" + options.value()["sat-count"]);
+                return 1;
+            }
+        }
+        if (option("equivalent")) {
+            const auto compared_IDs = get_signal_list(options.value()["equivalent"]);
+            if (not compared_IDs.has_value() || compared_IDs.value().size() != 2
+                || not is_displayed(netlist, compared_IDs.value()[0])
+                || not is_displayed(netlist, compared_IDs.value()[1])) {
+                display_error(INVALID_OPTION, 0, "--equivalent=" + options.value()["equivalent"]);
+                return 1;
+            }
+            compared = compared_IDs.value();
         }
 
-        std::sort(displaying_order.begin(), displaying_order.end());
+        if (option("optimise")) {
+            uint32_t saved;
+            const uint32_t gates = get_nodes_count(netlist) - get_start_nodes_count(netlist);
+            const auto optimise_start = std::chrono::steady_clock::now();
+            netlist = optimise_netlist(netlist, saved);
+            add_statistic(OPTIMISE_NS, elapsed_ns(optimise_start));
+            std::cerr << "Optimisation saved " << saved << " of " << gates
+                      << " gate evaluations per row.\n";
+        }
 
         // Performing the simulation
-        simulation(graph.value(), node_order.value(), displaying_order);
+        const auto engine = ENGINES.find(options.value()["engine"]);
+        const std::string engine_name = engine != ENGINES.end() ? engine->first : "scalar";
+        uint64_t last_row = option("rows")
+                            ? std::min<uint64_t>(last_row_number(netlist), numeric_option("rows", 1) - 1)
+                            : last_row_number(netlist);
+        if (option("to")) {
+            last_row = std::min(last_row, row_option("to"));
+        }
+        uint64_t first_row = option("from") ? row_option("from") : 0;
+        const std::string checkpoint = option("checkpoint") ? options.value()["checkpoint"] : "";
+        if (option("checkpoint")) {
+            // Resuming an interrupted run of the same range
+            const auto saved = load_checkpoint(checkpoint);
+            if (saved.has_value() && (std::get<1>(saved.value()) != last_row
+                                      || std::get<0>(saved.value()) < first_row)) {
+                display_error(INVALID_OPTION, 0, "--checkpoint=" + checkpoint);
+                return 1;
+            }
+            if (saved.has_value()) {
+                first_row = std::get<0>(saved.value());
+                rewind_output(std::get<2>(saved.value()));
+            }
+        }
+        const uint64_t rows = first_row <= last_row ? last_row - first_row + 1 : 0;
+        // The wavefront engine splits the rows itself
+        const uint32_t chunk_threads = engine_name == "wavefront" ? 1 : threads;
+        const Engine simulation_engine = ENGINES.find(engine_name)->second(netlist, threads);
+        // A stream without a buffer discards everything written to it
+        std::ostream discarded(nullptr);
+
+        const auto simulation_start = std::chrono::steady_clock::now();
+        if (option("sat-count") || option("equivalent")) {
+            // The answer is short and is the point of the run, so it isn't
+            // discarded with --benchmark, only kept out of the JSON
+            bdd_analysis(netlist, counted, compared, option("benchmark") ? std::cerr : std::cout);
+        }
+        else if (option("observe")) {
+            observed_simulation(netlist, simulation_engine, inputs, observed,
+                                last_row, option("benchmark") ? discarded : std::cout);
+        }
+        else if (option("activity")) {
+            activity_simulation(netlist, threads, first_row, last_row, option("benchmark") ? discarded : std::cout);
+        }
+        else {
+            simulation(netlist, simulation_engine, chunk_threads, first_row, last_row, checkpoint,
+                       option("benchmark") ? discarded : std::cout);
+        }
+        const auto simulation_end = std::chrono::steady_clock::now();
+
+        if (option("benchmark")) {
+            print_benchmark(engine_name, threads, netlist, rows, topo_sort_start - parse_start,
+                            topo_sort_end - topo_sort_start, simulation_end - simulation_start, std::cout);
+        }
+        if (option("stats")) {
+            print_statistics(netlist, rows, std::cerr);
+        }
     }
 
     return 0;
@@ -1,12 +1,18 @@
 #include "maptel.h"
 #include <string>
 #include <vector>
-#include <unordered_map>
+#include <tuple>
+#include <cstdint>
+#include <algorithm>
 #include <iostream>
-#include <unordered_set>
 #include <cstring>
 #include <cassert>
 #include <cctype>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include <array>
+#include <memory>
 
 #ifndef NDEBUG
 static const bool debug = true;
@@ -16,22 +22,152 @@ static const bool debug = false;
 
 using namespace std;
 
-using dict_map = unordered_map<string, string>;
-using global_map = unordered_map<unsigned long, dict_map>;
+// Number packed into 16 bytes: its first 16 digits in BCD, the first one
+// in the lowest bits + its other digits in BCD, with its length in the
+// highest byte
+using tel_key = pair<uint64_t, uint64_t>;
+
+static const size_t DICT_SHARDS = 16;
+static const int SHARD_SHIFT = 60;
+// An entry's id is its shard followed by its position in the shard
+static const int POSITION_BITS = 28;
+static const uint32_t NO_ENTRY = UINT32_MAX;
+static const size_t ENTRY_WORDS = 6;
+static const size_t FIRST_CHUNK_ENTRIES = 16;
+static const size_t ENTRY_CHUNKS = POSITION_BITS - 3;
+static const uint64_t CACHE_BUSY = UINT64_MAX;
+static const int LENGTH_SHIFT = 56;
+static const size_t BCD_DIGITS = 16;
+// Numbers of a batch packed and prefetched at a time
+static const size_t BATCH_BLOCK = 32;
+
+// A dictionary is split into shards by the hashes of the changed numbers.
+// A shard's index is an array of its size (a power of two) and the
+// open-addressing slots with the positions of the entries (position + 1,
+// 0 for empty slots, linear probing, at most 3/4 full).
+using dict_index = atomic<uint32_t>[];
+// The entries are kept in chunks which are never moved, each one twice as
+// big as the previous one (except for the second one), ENTRY_WORDS words
+// per entry: the changed number, the number after the change, the version
+// of the dictionary in which the final number of the chain of changes
+// starting here was cached (0 if never, CACHE_BUSY while a reader stores it)
+// and the id of the entry whose number after the change is that final
+// number (NO_ENTRY if the chain ends in a cycle). All the words are atomic,
+// so that readers may read them while a writer changes them.
+using dict_chunk = atomic<uint64_t>[];
+// Lock of the shard's writers + sequence number, odd while a writer changes
+// the shard + current index + number of entries + chunks + all the indexes
+// and chunks allocated so far, kept until the dictionary is deleted, since
+// readers may still be reading the old indexes
+using dict_shard = tuple<mutex, atomic<uint64_t>, atomic<atomic<uint32_t> *>, size_t,
+                         array<atomic<atomic<uint64_t> *>, ENTRY_CHUNKS>,
+                         vector<unique_ptr<dict_index>>, vector<unique_ptr<dict_chunk>>>;
+// Shards + version of the dictionary, increased by every change of a link,
+// which makes all the cached final numbers stale
+using dict = pair<array<dict_shard, DICT_SHARDS>, atomic<uint64_t>>;
+// Entry's id (NO_ENTRY if there's no entry) + number after the change
+// + cached version + cached final entry + words of the entry
+using entry_snapshot = tuple<uint32_t, tel_key, uint64_t, uint32_t, atomic<uint64_t> *>;
+
+// Dictionary + the next free identifier + 1 (0 if there's none), while
+// the slot's identifier is free
+using dict_slot = pair<atomic<dict *>, atomic<uint32_t>>;
+
+// Dictionaries by identifiers are kept in blocks of slots growing like the
+// chunks of entries, allocated when needed, so that neither finding a
+// dictionary nor creating or deleting different ones takes a lock.
+// Identifiers of deleted dictionaries are reused.
+static const size_t FIRST_REGISTRY_BLOCK = 256;
+static const size_t REGISTRY_BLOCKS = 25;
+static const unsigned long MAX_DICTS = UINT32_MAX;
+
+// Number of identifiers issued so far
+static atomic<unsigned long> number_of_dict(0);
+// Stack of free identifiers: its top + 1 (0 if it's empty) in the lowest
+// 32 bits and the number of its changes above, so that a thread which has
+// read an old top can't put it back
+static atomic<uint64_t> free_dicts(0);
+
+
+// Returns the first position in the chunk, when the first chunk has
+// first_size positions and every next one as many as all the previous ones.
+static inline size_t chunk_start(size_t chunk, size_t first_size) {
+    return chunk == 0 ? 0 : first_size << (chunk - 1);
+}
+
 
-static unsigned long number_of_dict = 0;
+static inline size_t position_chunk(size_t position, size_t first_size) {
+    size_t chunks = position / first_size;
+    return chunks == 0 ? 0 : 64 - __builtin_clzll(chunks);
+}
 
-static global_map& maps() {
-    static auto* ans = new global_map();
 
-    if (debug && ans == NULL) {
-        cerr << "maptel: failed to initialize register of maps\n";
-        assert(false);
+static array<atomic<dict_slot *>, REGISTRY_BLOCKS> &registry() {
+    static array<atomic<dict_slot *>, REGISTRY_BLOCKS> ans{};
+    return ans;
+}
+
+
+// Returns the dictionary's slot, allocating its block if create is set,
+// or NULL if there's no such slot.
+static dict_slot *registry_slot(unsigned long id, bool create) {
+    if (id >= MAX_DICTS) {
+        return NULL;
+    }
+
+    size_t block_index = position_chunk(id, FIRST_REGISTRY_BLOCK);
+    atomic<dict_slot *> &block = registry()[block_index];
+    dict_slot *slots = block.load(memory_order_acquire);
+    if (slots == NULL && create) {
+        size_t size = chunk_start(block_index + 1, FIRST_REGISTRY_BLOCK)
+                      - chunk_start(block_index, FIRST_REGISTRY_BLOCK);
+        auto *allocated = new dict_slot[size]();
+        if (block.compare_exchange_strong(slots, allocated, memory_order_acq_rel)) {
+            slots = allocated;
+        }
+        else {
+            delete[] allocated;
+        }
+    }
+
+    return slots == NULL ? NULL : &slots[id - chunk_start(block_index, FIRST_REGISTRY_BLOCK)];
+}
+
+
+static dict *find_dict(unsigned long id) {
+    dict_slot *slot = registry_slot(id, false);
+    return slot == NULL ? NULL : slot->first.load(memory_order_acquire);
+}
+
+
+static inline uint64_t next_free_top(uint64_t top, uint32_t id_plus_one) {
+    return (((top >> 32) + 1) << 32) | id_plus_one;
+}
+
+
+// Returns an identifier of a deleted dictionary, or a new one if there's none.
+static unsigned long take_id() {
+    uint64_t top = free_dicts.load(memory_order_acquire);
+    while (uint32_t(top) != 0) {
+        uint32_t next = registry_slot(uint32_t(top) - 1, false)->second.load(memory_order_relaxed);
+        if (free_dicts.compare_exchange_weak(top, next_free_top(top, next), memory_order_acq_rel)) {
+            return uint32_t(top) - 1;
+        }
     }
+    return number_of_dict.fetch_add(1);
+}
 
-    return *ans;
+
+static void release_id(unsigned long id) {
+    dict_slot *slot = registry_slot(id, false);
+    uint64_t top = free_dicts.load(memory_order_relaxed);
+    do {
+        slot->second.store(uint32_t(top), memory_order_relaxed);
+    } while (!free_dicts.compare_exchange_weak(top, next_free_top(top, uint32_t(id + 1)),
+                                               memory_order_release, memory_order_relaxed));
 }
 
+
 static inline bool correct_tel_chars(string tel) {
     for (auto c : tel) {
         if (!isdigit(c) && c != 0) {
@@ -42,12 +178,265 @@ static inline bool correct_tel_chars(string tel) {
 }
 
 
+static inline tel_key pack_tel(char const *tel) {
+    tel_key key(0, 0);
+    size_t len = 0;
+    for (; tel[len] != 0; len++) {
+        uint64_t digit = tel[len] - '0';
+        if (len < BCD_DIGITS) {
+            key.first |= digit << (4 * len);
+        }
+        else {
+            key.second |= digit << (4 * (len - BCD_DIGITS));
+        }
+    }
+    key.second |= uint64_t(len) << LENGTH_SHIFT;
+    return key;
+}
+
+
+static inline void unpack_tel(tel_key key, char *tel) {
+    size_t len = key.second >> LENGTH_SHIFT;
+    for (size_t i = 0; i < len; i++) {
+        uint64_t digits = i < BCD_DIGITS ? key.first >> (4 * i) : key.second >> (4 * (i - BCD_DIGITS));
+        tel[i] = char('0' + (digits & 0xF));
+    }
+    tel[len] = 0;
+}
+
+
+static inline size_t tel_hash(tel_key key) {
+    uint64_t h = key.first ^ (key.second * 0x9E3779B97F4A7C15ULL);
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    return size_t(h);
+}
+
+
+static inline uint64_t load_word(atomic<uint64_t> const &word) {
+    return word.load(memory_order_relaxed);
+}
+
+
+static inline void store_word(atomic<uint64_t> &word, uint64_t value) {
+    word.store(value, memory_order_relaxed);
+}
+
+
+// Returns NULL if a reader sees a position whose chunk isn't there yet,
+// which happens only if a writer changes the shard meanwhile.
+static inline atomic<uint64_t> *entry_words(dict_shard &shard, size_t position) {
+    size_t chunk = position_chunk(position, FIRST_CHUNK_ENTRIES);
+    atomic<uint64_t> *words = get<4>(shard)[chunk].load(memory_order_acquire);
+    if (words == nullptr) {
+        return nullptr;
+    }
+    return words + ENTRY_WORDS * (position - chunk_start(chunk, FIRST_CHUNK_ENTRIES));
+}
+
+
+static inline tel_key read_key(atomic<uint64_t> const *words) {
+    return tel_key(load_word(words[0]), load_word(words[1]));
+}
+
+
+static inline void write_key(atomic<uint64_t> *words, tel_key key) {
+    store_word(words[0], key.first);
+    store_word(words[1], key.second);
+}
+
+
+// Returns the slot of the key's position, or the empty slot where it belongs.
+// A reader may get any slot if a writer changes the shard meanwhile.
+static inline size_t probe(dict_shard &shard, atomic<uint32_t> *index, tel_key key) {
+    size_t mask = index[0].load(memory_order_relaxed) - 1;
+    size_t slot = tel_hash(key) & mask;
+    for (size_t i = 0; i <= mask; i++, slot = (slot + 1) & mask) {
+        uint32_t position = index[1 + slot].load(memory_order_relaxed);
+        if (position == 0) {
+            break;
+        }
+        atomic<uint64_t> *words = entry_words(shard, position - 1);
+        if (words != nullptr && read_key(words) == key) {
+            break;
+        }
+    }
+    return slot;
+}
+
+
+// Returns the position of the number's entry, or NO_ENTRY if there's none.
+static inline uint32_t find_position(dict_shard &shard, tel_key key) {
+    atomic<uint32_t> *index = get<2>(shard).load(memory_order_acquire);
+    if (index == nullptr) {
+        return NO_ENTRY;
+    }
+    uint32_t position = index[1 + probe(shard, index, key)].load(memory_order_relaxed);
+    atomic<uint64_t> *words = position == 0 ? nullptr : entry_words(shard, position - 1);
+    return words != nullptr && read_key(words) == key ? position - 1 : NO_ENTRY;
+}
+
+
+static inline dict_shard &key_shard(dict &curr_dict, tel_key key) {
+    return curr_dict.first[tel_hash(key) >> SHARD_SHIFT];
+}
+
+
+// Reads the entry of the number without locking, repeating the reading
+// until no writer has changed the shard meanwhile.
+static entry_snapshot read_entry(dict &curr_dict, tel_key key) {
+    size_t shard_index = tel_hash(key) >> SHARD_SHIFT;
+    dict_shard &shard = curr_dict.first[shard_index];
+
+    while (true) {
+        uint64_t sequence = get<1>(shard).load(memory_order_acquire);
+        entry_snapshot snapshot(NO_ENTRY, tel_key(0, 0), 0, NO_ENTRY, nullptr);
+        uint32_t position = sequence % 2 == 0 ? find_position(shard, key) : NO_ENTRY;
+
+        if (position != NO_ENTRY) {
+            atomic<uint64_t> *words = entry_words(shard, position);
+            // The cache is written by readers, outside of the sequence
+            uint64_t version = words[4].load(memory_order_acquire);
+            uint32_t final_entry = uint32_t(load_word(words[5]));
+            atomic_thread_fence(memory_order_acquire);
+            if (load_word(words[4]) != version) {
+                version = 0;
+            }
+            snapshot = entry_snapshot(uint32_t(shard_index << POSITION_BITS) | position,
+                                      read_key(words + 2), version, final_entry, words);
+        }
+
+        atomic_thread_fence(memory_order_acquire);
+        if (sequence % 2 == 0 && get<1>(shard).load(memory_order_relaxed) == sequence) {
+            return snapshot;
+        }
+    }
+}
+
+// Reads the number after the change in the entry with the id, like read_entry.
+// Returns false if the entry's chunk isn't there.
+static bool read_dst(dict &curr_dict, uint32_t id, tel_key *dst) {
+    dict_shard &shard = curr_dict.first[id >> POSITION_BITS];
+    uint32_t position = id & ((uint32_t(1) << POSITION_BITS) - 1);
+
+    while (true) {
+        uint64_t sequence = get<1>(shard).load(memory_order_acquire);
+        atomic<uint64_t> *words = entry_words(shard, position);
+        if (words != nullptr) {
+            *dst = read_key(words + 2);
+        }
+
+        atomic_thread_fence(memory_order_acquire);
+        if (sequence % 2 == 0 && get<1>(shard).load(memory_order_relaxed) == sequence) {
+            return words != nullptr;
+        }
+    }
+}
+
+
+static inline void begin_write(dict_shard &shard) {
+    store_word(get<1>(shard), load_word(get<1>(shard)) + 1);
+    atomic_thread_fence(memory_order_release);
+}
+
+
+static inline void end_write(dict_shard &shard) {
+    get<1>(shard).store(load_word(get<1>(shard)) + 1, memory_order_release);
+}
+
+
+// The following functions are called by the writer holding the shard's lock.
+
+// Aborts if the shard is full, since the position of the entry wouldn't
+// fit in its id, as maptel_create does when it runs out of ids.
+static void add_entry(dict_shard &shard, tel_key src, tel_key dst) {
+    atomic<uint32_t> *index = get<2>(shard).load(memory_order_relaxed);
+    size_t count = get<3>(shard);
+
+    if (count + 1 >= (size_t(1) << POSITION_BITS)) {
+        if (debug) {
+            cerr << "maptel: maptel_insert: too many numbers in a map\n";
+        }
+        abort();
+    }
+
+    size_t chunk = position_chunk(count, FIRST_CHUNK_ENTRIES);
+    if (get<4>(shard)[chunk].load(memory_order_relaxed) == nullptr) {
+        size_t entries = chunk_start(chunk + 1, FIRST_CHUNK_ENTRIES)
+                         - chunk_start(chunk, FIRST_CHUNK_ENTRIES);
+        unique_ptr<dict_chunk> allocated(new atomic<uint64_t>[ENTRY_WORDS * entries]());
+        get<4>(shard)[chunk].store(allocated.get(), memory_order_release);
+        get<6>(shard).push_back(move(allocated));
+    }
+
+    atomic<uint64_t> *words = entry_words(shard, count);
+    write_key(words, src);
+    write_key(words + 2, dst);
+    store_word(words[4], 0);
+
+    if (index == nullptr || 4 * (count + 1) > 3 * size_t(index[0].load(memory_order_relaxed))) {
+        size_t slots = index == nullptr ? 2 * FIRST_CHUNK_ENTRIES : 2 * size_t(index[0].load(memory_order_relaxed));
+        unique_ptr<dict_index> grown(new atomic<uint32_t>[1 + slots]());
+        grown[0].store(uint32_t(slots), memory_order_relaxed);
+        for (size_t position = 0; position < count; position++) {
+            size_t slot = probe(shard, grown.get(), read_key(entry_words(shard, position)));
+            grown[1 + slot].store(uint32_t(position + 1), memory_order_relaxed);
+        }
+
+        index = grown.get();
+        get<5>(shard).push_back(move(grown));
+        get<2>(shard).store(index, memory_order_release);
+    }
+
+    index[1 + probe(shard, index, src)].store(uint32_t(count + 1), memory_order_relaxed);
+    get<3>(shard)++;
+}
+
+
+// Empties the slot of the entry, moving back the slots which would not be
+// found past the hole otherwise, and moves the last entry into its place.
+static void remove_entry(dict_shard &shard, tel_key src) {
+    atomic<uint32_t> *index = get<2>(shard).load(memory_order_relaxed);
+    size_t mask = index[0].load(memory_order_relaxed) - 1;
+
+    size_t hole = probe(shard, index, src);
+    size_t position = index[1 + hole].load(memory_order_relaxed) - 1;
+    for (size_t slot = (hole + 1) & mask; index[1 + slot].load(memory_order_relaxed) != 0; slot = (slot + 1) & mask) {
+        uint32_t moved = index[1 + slot].load(memory_order_relaxed);
+        size_t home = tel_hash(read_key(entry_words(shard, moved - 1))) & mask;
+        if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+            index[1 + hole].store(moved, memory_order_relaxed);
+            hole = slot;
+        }
+    }
+    index[1 + hole].store(0, memory_order_relaxed);
+
+    size_t last = --get<3>(shard);
+    if (position != last) {
+        atomic<uint64_t> *from = entry_words(shard, last);
+        atomic<uint64_t> *to = entry_words(shard, position);
+        write_key(to, read_key(from));
+        write_key(to + 2, read_key(from + 2));
+        store_word(to[4], 0);
+        index[1 + probe(shard, index, read_key(to))].store(uint32_t(position + 1), memory_order_relaxed);
+    }
+}
+
+
+// Called inside the write, so that a reader which sees the change also sees
+// the new version.
+static inline void bump_version(dict &curr_dict) {
+    curr_dict.second.fetch_add(1, memory_order_release);
+}
+
+
 static inline void maptel_create_debug(unsigned long id) {
-    if (maps().find(id) == maps().end()) {
+    if (find_dict(id) == NULL) {
         cerr << "maptel: maptel_create: failed to create map " << id << "\n";
         assert(false);
     }
-    cerr << "maptel: maptel_create: new map id = " << number_of_dict << "\n";
+    cerr << "maptel: maptel_create: new map id = " << id << "\n";
 }
 
 
@@ -56,20 +445,26 @@ unsigned long jnp1::maptel_create(void) {
         cerr << "maptel: maptel_create()\n";
     }
 
-    maps()[number_of_dict];
+    unsigned long id = take_id();
+    dict_slot *slot = registry_slot(id, true);
+    if (slot == NULL) {
+        if (debug) {
+            cerr << "maptel: maptel_create: too many maps\n";
+        }
+        abort();
+    }
+    slot->first.store(new dict(), memory_order_release);
 
     if (debug) {
-        maptel_create_debug(number_of_dict);
+        maptel_create_debug(id);
     }
 
-    unsigned long temp = number_of_dict;
-    number_of_dict++;
-    return temp;
+    return id;
 }
 
 
 static inline void maptel_predelete_debug(unsigned long id) {
-    if (maps().find(id) == maps().end()) {
+    if (find_dict(id) == NULL) {
         cerr << "maptel: maptel_delete: map " << id << " doesn't exists\n";
         assert(false);
     }
@@ -77,7 +472,7 @@ static inline void maptel_predelete_debug(unsigned long id) {
 
 
 static inline void maptel_postdelete_debug(unsigned long id) {
-    if (maps().find(id) == maps().end()) {
+    if (find_dict(id) == NULL) {
         cerr << "maptel: maptel_delete: map " << id << " deleted\n";
     }
     else {
@@ -94,7 +489,12 @@ void jnp1::maptel_delete(unsigned long id) {
         maptel_predelete_debug(id);
     }
 
-    maps().erase(id);
+    dict_slot *slot = registry_slot(id, false);
+    dict *deleted = slot == NULL ? NULL : slot->first.exchange(NULL, memory_order_acq_rel);
+    if (deleted != NULL) {
+        delete deleted;
+        release_id(id);
+    }
 
     if (debug) {
         maptel_postdelete_debug(id);
@@ -104,7 +504,7 @@ void jnp1::maptel_delete(unsigned long id) {
 
 static inline void maptel_preinsert_debug(unsigned long id, char const *tel_src, char const *tel_dst) {
 
-    if (maps().find(id) == maps().end()) {
+    if (find_dict(id) == NULL) {
         cerr << "maptel: maptel_insert: map doesn't exist\n";
         assert(false);
     }
@@ -147,12 +547,13 @@ static inline void maptel_preinsert_debug(unsigned long id, char const *tel_src,
 
 
 static inline void maptel_postinsert_debug(unsigned long id, char const *tel_src, char const *tel_dst) {
-    if (maps()[id].find(tel_src) == maps()[id].end()) {
+    entry_snapshot entry = read_entry(*find_dict(id), pack_tel(tel_src));
+    if (get<0>(entry) == NO_ENTRY) {
         cerr << "maptel: maptel_insert: failed to add member " << tel_src << " to map " << id << "\n";
         assert(false);
     }
 
-    if (maps()[id][tel_src] != tel_dst) {
+    if (get<1>(entry) != pack_tel(tel_dst)) {
         cerr << "maptel: maptel_insert: inserted incorrect tel_dst for member " << tel_src << "\n";
         assert(false);
     }
@@ -165,9 +566,27 @@ void jnp1::maptel_insert(unsigned long id, char const *tel_src, char const *tel_
     if (debug) {
         maptel_preinsert_debug(id, tel_src, tel_dst);
     }
-    string src(tel_src);
-    string dst(tel_dst);
-    maps()[id][src] = dst;
+    dict &curr_dict = *find_dict(id);
+    tel_key src = pack_tel(tel_src);
+    tel_key dst = pack_tel(tel_dst);
+    dict_shard &shard = key_shard(curr_dict, src);
+
+    {
+        lock_guard<mutex> lock(get<0>(shard));
+        uint32_t position = find_position(shard, src);
+        atomic<uint64_t> *words = position == NO_ENTRY ? nullptr : entry_words(shard, position);
+        if (words == nullptr || read_key(words + 2) != dst) {
+            begin_write(shard);
+            if (words == nullptr) {
+                add_entry(shard, src, dst);
+            }
+            else {
+                write_key(words + 2, dst);
+            }
+            bump_version(curr_dict);
+            end_write(shard);
+        }
+    }
 
     if (debug) {
         maptel_postinsert_debug(id, tel_src, tel_dst);
@@ -183,7 +602,7 @@ static inline void maptel_preerase_debug(unsigned long id, char const *tel_src,
 
     cerr << "maptel: maptel_erase(" << id << ", " << tel_src << ")\n";
 
-    if (maps().find(id) == maps().end()) {
+    if (find_dict(id) == NULL) {
         cerr << "maptel: maptel_erase: nothing to erase\n";
         assert(false);
     }
@@ -204,14 +623,14 @@ static inline void maptel_preerase_debug(unsigned long id, char const *tel_src,
         assert(false);
     }
 
-    if (maps()[id].find(src) != maps()[id].end()) {
+    if (get<0>(read_entry(*find_dict(id), pack_tel(tel_src))) != NO_ENTRY) {
         *tel_src_present = true;
     }
 }
 
 
 static inline void maptel_posterase_debug(unsigned long id, char const *tel_src, bool const tel_src_present) {
-    if (maps()[id].find(tel_src) != maps()[id].end()) {
+    if (get<0>(read_entry(*find_dict(id), pack_tel(tel_src))) != NO_ENTRY) {
         cerr << "maptel: maptel_erase: failed to erase tel " << tel_src << " from map " << id << "\n";
         assert(false);
     }
@@ -230,8 +649,19 @@ void jnp1::maptel_erase(unsigned long id, char const *tel_src) {
     if (debug) {
         maptel_preerase_debug(id, tel_src, &tel_src_present);
     }
-    string x(tel_src);
-    maps()[id].erase(x);
+    dict &curr_dict = *find_dict(id);
+    tel_key src = pack_tel(tel_src);
+    dict_shard &shard = key_shard(curr_dict, src);
+
+    {
+        lock_guard<mutex> lock(get<0>(shard));
+        if (find_position(shard, src) != NO_ENTRY) {
+            begin_write(shard);
+            remove_entry(shard, src);
+            bump_version(curr_dict);
+            end_write(shard);
+        }
+    }
 
     if (debug) {
         maptel_posterase_debug(id, tel_src, tel_src_present);
@@ -256,7 +686,7 @@ static inline void maptel_pretransform_debug(unsigned long id, char const *tel_s
     }
 
     cerr << "maptel: maptel_transform(" << id << ", " << tel_src << ", " << (void*)tel_dst << ", " << len << ")\n";
-    if (maps().find(id) == maps().end()) {
+    if (find_dict(id) == NULL) {
         cerr << "maptel: maptel_transform: map " << id << " doesn't exists\n";
         assert(false);
     }
@@ -297,44 +727,325 @@ static inline void maptel_posttransform_debug(char const *tel_src, char *tel_dst
 }
 
 
-void jnp1::maptel_transform(unsigned long id, char const *tel_src, char *tel_dst, size_t len) {
-    if (debug) {
-        maptel_pretransform_debug(id, tel_src, tel_dst, len);
+// Caches the final entry in the entry, unless another reader is caching
+// something in it at the same time. seen is the cached version read before.
+static inline void cache_final_entry(atomic<uint64_t> *words, uint64_t seen, uint64_t version, uint32_t final_entry) {
+    if (seen == CACHE_BUSY || !words[4].compare_exchange_strong(seen, CACHE_BUSY, memory_order_acquire)) {
+        return;
     }
+    atomic_thread_fence(memory_order_release);
+    store_word(words[5], final_entry);
+    words[4].store(version, memory_order_release);
+}
 
-    string src(tel_src);
-    bool cycle_detected = false;
-    unordered_set<string> visited;
-    visited.insert(src);
 
-    auto curr_map = maps()[id];
-    auto it = curr_map.find(src);
+// Follows the chain of changes from the number without locking and caches
+// its final number in the entries on the way, which end the same way. The
+// chain stops at the first entry cached in the current version, and Brent's
+// algorithm detects cycles without remembering the visited numbers. The
+// whole walk is repeated if a writer has changed the dictionary meanwhile.
+// Returns false if the number isn't changed or its chain ends in a cycle,
+// and puts the final number in *final_tel otherwise.
+static bool resolve_chain(dict &curr_dict, tel_key src, tel_key *final_tel, bool *cycle_detected) {
+    while (true) {
+        const uint64_t version = curr_dict.second.load(memory_order_acquire);
+        entry_snapshot start = read_entry(curr_dict, src);
+        if (get<0>(start) == NO_ENTRY) {
+            *cycle_detected = false;
+            return false;
+        }
 
-    while (it != curr_map.end()) {
-        string dst = it->second;
+        uint32_t final_entry = get<3>(start);
+        bool final_read = false;
+        bool stale = false;
+        size_t hops = 0;
+
+        if (get<2>(start) != version) {
+            entry_snapshot current = start;
+            uint32_t tortoise = get<0>(start);
+            size_t power = 1;
+            size_t steps = 0;
+
+            while (true) {
+                entry_snapshot next = read_entry(curr_dict, get<1>(current));
+                if (get<0>(next) == NO_ENTRY) {
+                    final_entry = get<0>(current);
+                    *final_tel = get<1>(current);
+                    final_read = true;
+                    break;
+                }
+                if (get<2>(next) == version) {
+                    final_entry = get<3>(next);
+                    break;
+                }
+
+                current = next;
+                hops++;
+                steps++;
+                if (get<0>(current) == tortoise) {
+                    final_entry = NO_ENTRY;
+                    break;
+                }
+                if (steps == power) {
+                    if (curr_dict.second.load(memory_order_acquire) != version) {
+                        stale = true;
+                        break;
+                    }
+                    tortoise = get<0>(current);
+                    power *= 2;
+                    steps = 0;
+                }
+            }
+        }
 
-        if (visited.find(dst) != visited.end()) {
-            cycle_detected = true;
-            src = tel_src;
-            break;
+        if (!stale && final_entry != NO_ENTRY && !final_read) {
+            stale = !read_dst(curr_dict, final_entry, final_tel);
         }
-        else {
-            visited.insert(dst);
-            src = dst;
-            it = curr_map.find(src);
+        atomic_thread_fence(memory_order_acquire);
+        if (stale || curr_dict.second.load(memory_order_relaxed) != version) {
+            continue;
+        }
+
+        entry_snapshot current = start;
+        for (size_t i = 0; i <= hops && get<0>(current) != NO_ENTRY && get<2>(current) != version; i++) {
+            cache_final_entry(get<4>(current), get<2>(current), version, final_entry);
+            current = read_entry(curr_dict, get<1>(current));
         }
+
+        *cycle_detected = final_entry == NO_ENTRY;
+        return final_entry != NO_ENTRY;
     }
+}
+
 
-    auto result = src.c_str();
+void jnp1::maptel_transform(unsigned long id, char const *tel_src, char *tel_dst, size_t len) {
+    if (debug) {
+        maptel_pretransform_debug(id, tel_src, tel_dst, len);
+    }
+
+    tel_key final_key;
+    bool cycle_detected;
+    bool changed = resolve_chain(*find_dict(id), pack_tel(tel_src), &final_key, &cycle_detected);
+
+    char final_tel[jnp1::TEL_NUM_MAX_LEN + 1];
+    if (changed) {
+        unpack_tel(final_key, final_tel);
+    }
+    auto result = changed ? final_tel : tel_src;
     if (debug) {
         if (cycle_detected) {
             cerr << "maptel: maptel_transform: cycle detected\n";
         }
         maptel_transform_len_check(result, len);
     }
-        strcpy(tel_dst, result);
+    // tel_dst may be tel_src
+    memmove(tel_dst, result, strlen(result) + 1);
 
     if (debug) {
         maptel_posttransform_debug(tel_src, tel_dst, result, cycle_detected);
     }
 }
+
+
+static inline void maptel_prebatch_debug(char const *func, unsigned long id, void const *tels, size_t count) {
+    cerr << "maptel: " << func << "(" << id << ", " << tels << ", " << count << ")\n";
+
+    if (find_dict(id) == NULL) {
+        cerr << "maptel: " << func << ": map " << id << " doesn't exists\n";
+        assert(false);
+    }
+
+    if (count > 0 && tels == NULL) {
+        cerr << "maptel: " << func << ": pointer is null\n";
+        assert(false);
+    }
+}
+
+
+static inline void maptel_batch_tel_debug(char const *func, char const *tel) {
+    if (tel == NULL) {
+        cerr << "maptel: " << func << ": pointer is null\n";
+        assert(false);
+    }
+
+    if (strcmp(tel, "") == 0) {
+        cerr << "maptel: " << func << ": tel is empty\n";
+        assert(false);
+    }
+
+    string number(tel);
+    if (number.size() > jnp1::TEL_NUM_MAX_LEN) {
+        cerr << "maptel: " << func << ": tel is too long\n";
+        assert(false);
+    }
+
+    if (!correct_tel_chars(number)) {
+        cerr << "maptel: " << func << ": tel is incorrect\n";
+        assert(false);
+    }
+}
+
+
+// Packs a block of numbers of a batch and prefetches their slots, and then
+// their entries, so that the misses of the whole block overlap.
+static void prepare_block(dict &curr_dict, char const *const *tels, size_t count, tel_key *keys) {
+    atomic<uint32_t> *slots[BATCH_BLOCK];
+
+    for (size_t i = 0; i < count; i++) {
+        keys[i] = pack_tel(tels[i]);
+        atomic<uint32_t> *index = get<2>(key_shard(curr_dict, keys[i])).load(memory_order_acquire);
+        slots[i] = index == nullptr ? nullptr
+                                    : &index[1 + (tel_hash(keys[i]) & (index[0].load(memory_order_relaxed) - 1))];
+        if (slots[i] != nullptr) {
+            __builtin_prefetch(slots[i]);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t position = slots[i] == nullptr ? 0 : slots[i]->load(memory_order_relaxed);
+        atomic<uint64_t> *words = position == 0 ? nullptr : entry_words(key_shard(curr_dict, keys[i]), position - 1);
+        if (words != nullptr) {
+            __builtin_prefetch(words);
+        }
+    }
+}
+
+
+// Changes the numbers of a block of a batch, one shard at a time, so that
+// every shard is locked and written once per block. The changes of the
+// same number stay in order, since it's always in the same shard. Erases
+// the numbers if tel_dst is NULL.
+static void change_block(dict &curr_dict, tel_key const *src, char const *const *tel_dst, size_t count) {
+    for (size_t shard_index = 0; shard_index < DICT_SHARDS; shard_index++) {
+        dict_shard &shard = curr_dict.first[shard_index];
+        unique_lock<mutex> lock(get<0>(shard), defer_lock);
+        bool writing = false;
+
+        for (size_t i = 0; i < count; i++) {
+            if (tel_hash(src[i]) >> SHARD_SHIFT != shard_index) {
+                continue;
+            }
+            if (!lock.owns_lock()) {
+                lock.lock();
+            }
+
+            uint32_t position = find_position(shard, src[i]);
+            atomic<uint64_t> *words = position == NO_ENTRY ? nullptr : entry_words(shard, position);
+            tel_key dst = tel_dst == NULL ? tel_key(0, 0) : pack_tel(tel_dst[i]);
+            bool change = tel_dst == NULL ? words != nullptr : words == nullptr || read_key(words + 2) != dst;
+            if (!change) {
+                continue;
+            }
+
+            if (!writing) {
+                begin_write(shard);
+                writing = true;
+            }
+            if (tel_dst == NULL) {
+                remove_entry(shard, src[i]);
+            }
+            else if (words == nullptr) {
+                add_entry(shard, src[i], dst);
+            }
+            else {
+                write_key(words + 2, dst);
+            }
+        }
+
+        if (writing) {
+            bump_version(curr_dict);
+            end_write(shard);
+        }
+    }
+}
+
+
+void jnp1::maptel_insert_batch(unsigned long id, char const *const *tel_src,
+                               char const *const *tel_dst, size_t count) {
+    if (debug) {
+        maptel_prebatch_debug("maptel_insert_batch", id, tel_src, count);
+        if (count > 0 && tel_dst == NULL) {
+            cerr << "maptel: maptel_insert_batch: pointer is null\n";
+            assert(false);
+        }
+        for (size_t i = 0; i < count; i++) {
+            maptel_batch_tel_debug("maptel_insert_batch", tel_src[i]);
+            maptel_batch_tel_debug("maptel_insert_batch", tel_dst[i]);
+        }
+    }
+
+    dict &curr_dict = *find_dict(id);
+    tel_key src[BATCH_BLOCK];
+    for (size_t first = 0; first < count; first += BATCH_BLOCK) {
+        size_t block = min(BATCH_BLOCK, count - first);
+        prepare_block(curr_dict, tel_src + first, block, src);
+        change_block(curr_dict, src, tel_dst + first, block);
+    }
+
+    if (debug) {
+        cerr << "maptel: maptel_insert_batch: inserted " << count << "\n";
+    }
+}
+
+
+void jnp1::maptel_erase_batch(unsigned long id, char const *const *tel_src, size_t count) {
+    if (debug) {
+        maptel_prebatch_debug("maptel_erase_batch", id, tel_src, count);
+        for (size_t i = 0; i < count; i++) {
+            maptel_batch_tel_debug("maptel_erase_batch", tel_src[i]);
+        }
+    }
+
+    dict &curr_dict = *find_dict(id);
+    tel_key src[BATCH_BLOCK];
+    for (size_t first = 0; first < count; first += BATCH_BLOCK) {
+        size_t block = min(BATCH_BLOCK, count - first);
+        prepare_block(curr_dict, tel_src + first, block, src);
+        change_block(curr_dict, src, NULL, block);
+    }
+
+    if (debug) {
+        cerr << "maptel: maptel_erase_batch: erased " << count << "\n";
+    }
+}
+
+
+void jnp1::maptel_transform_batch(unsigned long id, char const *const *tel_src,
+                                  char *tel_dst, size_t len, size_t count) {
+    if (debug) {
+        maptel_prebatch_debug("maptel_transform_batch", id, tel_src, count);
+        if (count > 0 && tel_dst == NULL) {
+            cerr << "maptel: maptel_transform_batch: tel_dst is null\n";
+            assert(false);
+        }
+        for (size_t i = 0; i < count; i++) {
+            maptel_batch_tel_debug("maptel_transform_batch", tel_src[i]);
+        }
+    }
+
+    dict &curr_dict = *find_dict(id);
+    tel_key src[BATCH_BLOCK];
+    for (size_t first = 0; first < count; first += BATCH_BLOCK) {
+        size_t block = min(BATCH_BLOCK, count - first);
+        prepare_block(curr_dict, tel_src + first, block, src);
+
+        for (size_t i = 0; i < block; i++) {
+            tel_key final_key;
+            bool cycle_detected;
+            // Not reading tel_src again, it may be already overwritten
+            // when it points into tel_dst
+            char final_tel[jnp1::TEL_NUM_MAX_LEN + 1];
+            unpack_tel(resolve_chain(curr_dict, src[i], &final_key, &cycle_detected) ? final_key : src[i],
+                       final_tel);
+
+            if (debug) {
+                maptel_transform_len_check(final_tel, len);
+            }
+            strcpy(tel_dst + (first + i) * len, final_tel);
+        }
+    }
+
+    if (debug) {
+        cerr << "maptel: maptel_transform_batch: transformed " << count << "\n";
+    }
+}
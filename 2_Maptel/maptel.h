@@ -28,9 +28,27 @@ extern "C" {
         // tel_src. Podąża ciągiem kolejnych zmian. Zapisuje zmieniony numer w tel_dst.
         // Jeśli nie ma zmiany numeru lub zmiany tworzą cykl, to zapisuje w tel_dst
         // numer tel_src. Wartość len to rozmiar przydzielonej pamięci wskazywanej
-        // przez tel_dst.
+        // przez tel_dst. Wskaźnik tel_dst może być równy tel_src.
         void maptel_transform(unsigned long id, char const *tel_src, char *tel_dst, size_t len);
 
+        // Wstawia do słownika o identyfikatorze id informacje o zmianach numerów
+        // tel_src[i] na numery tel_dst[i] dla i = 0, ..., count - 1, tak jak
+        // kolejne wywołania maptel_insert.
+        void maptel_insert_batch(unsigned long id, char const *const *tel_src,
+                                 char const *const *tel_dst, size_t count);
+
+        // Usuwa ze słownika o identyfikatorze id informacje o zmianach numerów
+        // tel_src[i] dla i = 0, ..., count - 1, tak jak kolejne wywołania
+        // maptel_erase.
+        void maptel_erase_batch(unsigned long id, char const *const *tel_src, size_t count);
+
+        // Dla i = 0, ..., count - 1 zapisuje zmieniony numer tel_src[i], tak jak
+        // maptel_transform, w pamięci o rozmiarze len zaczynającej się od
+        // tel_dst + i * len. Wartość len to rozmiar miejsca na jeden numer.
+        // Wskaźnik tel_src[i] może być równy tel_dst + i * len.
+        void maptel_transform_batch(unsigned long id, char const *const *tel_src,
+                                    char *tel_dst, size_t len, size_t count);
+
 #ifdef __cplusplus
     }
 }